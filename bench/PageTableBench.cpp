@@ -0,0 +1,92 @@
+// Microbenchmark: hit-path lookup latency of the buffer page table.
+//
+// Compares the legacy chained utils::HashMap<HashItemTwoInt> against the
+// open-addressing fs::PageTable with the buffer pool fully populated, i.e.
+// exactly the state getPage() sees during a scan or an index probe.
+//
+// Build with -DDBS_BUILD_BENCHMARKS=ON and run ./page_table_bench [rounds].
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "fs/PageTable.hpp"
+#include "utils/HashMap.hpp"
+
+using namespace dbs;
+
+namespace {
+
+struct Probe {
+    int fileID, pageID;
+};
+
+template <typename F>
+double nanosPerOp(const std::vector<Probe>& probes, int rounds, long long& sink, F lookup) {
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        for (const Probe& p : probes) {
+            sink += lookup(p.fileID, p.pageID);
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    return ns / (static_cast<double>(rounds) * probes.size());
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    int rounds = argc > 1 ? std::atoi(argv[1]) : 200;
+    const int files = 8;
+
+    // Resident pages: CACHE_CAPACITY frames spread over a few open files,
+    // mirroring a pool filled by a scan over several tables and indexes.
+    std::vector<Probe> resident;
+    for (int i = 0; i < CACHE_CAPACITY; ++i) {
+        resident.push_back({i % files, i / files});
+    }
+
+    utils::HashMap<utils::HashItemTwoInt> chained;
+    fs::PageTable flat(CACHE_CAPACITY);
+    for (int i = 0; i < CACHE_CAPACITY; ++i) {
+        chained.insertItem(utils::HashItemTwoInt(resident[i].fileID, resident[i].pageID, i));
+        flat.insert(resident[i].fileID, resident[i].pageID, i);
+    }
+
+    std::vector<Probe> sequential = resident;
+    std::vector<Probe> shuffled = resident;
+    std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(42));
+
+    long long sink = 0;
+    auto chainedLookup = [&](int f, int p) {
+        return chained.findItem(utils::HashItemTwoInt(f, p)).value;
+    };
+    auto flatLookup = [&](int f, int p) { return flat.find(f, p); };
+
+    std::printf("%-12s %-22s %10s\n", "pattern", "table", "ns/lookup");
+    for (int pass = 0; pass < 2; ++pass) {
+        const std::vector<Probe>& probes = pass == 0 ? sequential : shuffled;
+        const char* name = pass == 0 ? "sequential" : "random";
+        std::printf("%-12s %-22s %10.2f\n", name, "utils::HashMap",
+                    nanosPerOp(probes, rounds, sink, chainedLookup));
+        std::printf("%-12s %-22s %10.2f\n", name, "fs::PageTable",
+                    nanosPerOp(probes, rounds, sink, flatLookup));
+    }
+
+    // Miss path: pages that are not resident.
+    std::vector<Probe> misses;
+    for (int i = 0; i < CACHE_CAPACITY; ++i) {
+        misses.push_back({files + i % files, i});
+    }
+    std::printf("%-12s %-22s %10.2f\n", "miss", "utils::HashMap",
+                nanosPerOp(misses, rounds, sink, chainedLookup));
+    std::printf("%-12s %-22s %10.2f\n", "miss", "fs::PageTable",
+                nanosPerOp(misses, rounds, sink, flatLookup));
+
+    std::fprintf(stderr, "checksum %lld\n", sink);
+    return 0;
+}
@@ -26,6 +26,7 @@ typedef unsigned int* BufType;  // 定义 BufType 为无符号整型指针
 #define BUF_PER_PAGE 2048  // 每个页面的缓冲区数量
 #define BIT_PER_PAGE 65536  // 每个页面包含 65536 位
 #define PAGE_SIZE_IDX 13  // 页面大小的对数，2^13 = 8192
+#define DIRECT_IO_ALIGNMENT 4096  // O_DIRECT 要求的缓冲区与偏移对齐，单位为字节
 
 // 哈希相关常量
 #define HASH_MOD 6007  // 哈希表的模数
@@ -33,7 +34,9 @@ typedef unsigned int* BufType;  // 定义 BufType 为无符号整型指针
 #define HASH_PRIME_2 89  // 哈希表的第二个质数
 
 // 缓存相关常量
-#define CACHE_CAPACITY 6000  // 缓存容量，单位为条目
+#define CACHE_CAPACITY 6000  // 默认缓存容量，单位为条目（可用 --buffer-pool-mb 覆盖）
+#define FILE_HANDLE_CACHE_CAPACITY 64  // 同时打开的数据文件数上限（可用 --open-files 覆盖）
+#define MIN_FILE_HANDLE_CACHE_CAPACITY 4  // 下限：一次操作可能同时固定记录、空闲空间映射和索引文件的页面
 
 // 记录管理相关常量
 #define RECORD_META_DATA_LENGTH 80  // 记录的元数据长度，单位为字节
@@ -41,16 +44,39 @@ typedef unsigned int* BufType;  // 定义 BufType 为无符号整型指针
 #define MAX_COLUMN_NUM 102  // 最大列数
 #define RECORD_PAGE_HEADER 64  // 记录页面头部长度，单位为字节
 #define MAX_ITEM_PER_PAGE 512  // 每页最多条目数
+#define SLOT_SELECTION_BUF 16  // 扫描时每页槽选择位图的 buf 数（MAX_ITEM_PER_PAGE / 32）
+#define SCAN_MORSEL_PAGES 32  // 并行扫描时每个任务（morsel）包含的页数，表不足两个 morsel 时串行扫描
+#define LOAD_CHUNK_BYTES (4 << 20)  // LOAD DATA 并行解析时每个任务的输入字节数，按行边界切分
+// 记录页头的占用摘要。记录长度至少 32 字节，每页至多 254 个槽，槽位图只用到头部前 8 个 buf，
+// 摘要放在末尾：[13] 标识，[14] 有效槽数，[15] 标志位。旧页面没有标识，按槽位图处理
+#define RECORD_PAGE_SUMMARY_BUF 13
+#define RECORD_PAGE_SUMMARY_MAGIC 0x4f434331  // 页面摘要标识 "OCC1"
+#define RECORD_PAGE_FULL 1   // 页面已满
+#define RECORD_PAGE_EMPTY 2  // 页面没有有效记录
+// 变长（slotted）记录格式：元数据页列位图中未使用的最高位标记该表使用此格式。
+// 数据页页头：[0..7] 槽位图，[8] 槽目录项数，[9] 记录区起始字节偏移，[13..15] 占用摘要；
+// 槽目录紧跟页头，每项 4 字节：低 16 位偏移，16..29 位长度，30 位转发，31 位迁入
+#define RECORD_FORMAT_FLAG_BIT 127
+#define RECORD_PAX_FLAG_BIT 126  // PAX 格式标记：槽与定长格式相同，页内每列的值连续存放（列小页）
+#define SLOTTED_MAX_SLOTS 256  // 每页最多槽数，槽位图只占页头前 8 个 buf
+#define SLOTTED_FORWARD 0x40000000U   // 记录更新后放不下，槽中只存新位置 (pageId, slotId)
+#define SLOTTED_MOVED_IN 0x80000000U  // 由转发槽指向的记录，扫描时跳过
+#define FREE_SPACE_MAP_SUFFIX "_FSM"  // 空闲空间映射文件后缀，与记录文件位于同一目录
+#define FREE_SPACE_MAP_MAGIC 0x46534d31  // 空闲空间映射文件头标识 "FSM1"
+#define SCHEMA_CACHE_CAPACITY 256  // 缓存的表结构数上限，超出时全部丢弃，之后按需重新读取元数据页
 
 // 索引管理相关常量
 #define INDEX_HEADER_BYTE_LEN 16         // 索引头部字节长度，单位为字节
 #define INDEX_BITMAP_PAGE_BYTE_LEN 8188  // 索引位图页面字节长度，单位为字节
+#define INDEX_BULK_FILL_PERCENT 90  // 批量建索引时每个节点的填充率（百分比），不会低于节点半满
+#define INDEX_SORT_MEMORY_BYTES (64 << 20)  // 批量建索引时内存排序的上限，超出后分段排序写入临时文件再归并
 
 // 数据路径相关常量
 #define DATABASE_PATH "./data"  // 数据库路径
 #define DATABASE_BASE_PATH "./data/base"  // 数据库基础路径
 #define DATABASE_GLOBAL_PATH "./data/global"  // 数据库全局路径
 #define DATABASE_GLOBAL_RECORD_PATH "./data/global/ALLDatabase"  // 全局数据库记录路径
+#define WAL_FILE_PATH "./data/global/WAL"  // 预写日志文件路径
 #define DATABSE_FOLDER_PREFIX "DB"  // 数据库文件夹前缀
 #define TABLE_FOLDER_PREFIX "TB"  // 表文件夹前缀
 #define INDEX_FOLDER_NAME "IndexFiles"  // 索引文件夹名称
@@ -1,9 +1,21 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
 #include "fs/FileManager.hpp"
 #include "fs/FindReplace.hpp"
-#include "utils/BitMap.hpp"
-#include "utils/HashMap.hpp"
+#include "fs/PageTable.hpp"
+#include "fs/ReadAhead.hpp"
+#include "fs/WriteAheadLog.hpp"
 
 namespace dbs {
 namespace fs {
@@ -13,15 +25,129 @@ struct PageLocation {
 
     PageLocation() : fileID(-1), pageID(-1) {}
     PageLocation(int fileID_, int pageID_) : fileID(fileID_), pageID(pageID_) {}
+};
+
+/**
+ * @brief When modified pages (or their log records) are forced to disk.
+ */
+enum class Durability {
+    OFF,       // never fsync; survives a process crash only with the log
+    PERIODIC,  // fsync at most every syncIntervalMs: the log by a background thread,
+               // the data files (without a log) by the first commit after the interval
+    STRICT     // fsync before every statement returns
+};
+
+/**
+ * @brief Startup configuration of the buffer pool.
+ */
+struct BufferPoolOptions {
+    int frameCount = CACHE_CAPACITY;             // number of 8KB frames
+    ReplacePolicy policy = ReplacePolicy::LRU;  // victim selection policy
+    bool hugePages = false;  // ask for transparent huge pages on the arena
+    int readAheadPages = 32;  // scan read-ahead window in pages, 0 disables
+    bool ioUring = true;      // issue read-ahead through io_uring when available
+    int dirtyThresholdPercent = 10;  // background writer starts above this dirty ratio, 0 disables it
+    int writerIntervalMs = 20;       // background writer wake-up period
+    int shards = 0;  // latch partitions, 0 picks one per hardware thread
+    int checkpointMegabytes = 64;  // checkpoint once the write-ahead log grows past this
+    Durability durability = Durability::STRICT;
+    int syncIntervalMs = 100;  // fsync period of Durability::PERIODIC
+
+    /**
+     * @brief Shard count actually used: a power of two, at most MAX_SHARDS,
+     *        and small enough that every shard keeps MIN_SHARD_FRAMES frames.
+     */
+    int resolveShards() const;
+
+    static constexpr int MAX_SHARDS = 64;
+    static constexpr int MIN_SHARD_FRAMES = 64;
+
+    /**
+     * @brief Converts a pool size in megabytes to a frame count.
+     */
+    static int framesForMegabytes(int megabytes) {
+        return static_cast<int>((static_cast<long long>(megabytes) << 20) / PAGE_SIZE_BY_BYTE);
+    }
+};
+
+/**
+ * @brief Buffer pool counters, for the whole pool or for one file.
+ */
+struct BufferStats {
+    uint64_t hits = 0;         // requests served from a resident frame
+    uint64_t misses = 0;       // pages read into a frame
+    uint64_t evictions = 0;    // resident pages replaced by another page
+    uint64_t dirtyWrites = 0;  // dirty pages written back, for any reason
+    uint64_t readBytes = 0;
+    uint64_t writeBytes = 0;
 
-    utils::HashItemTwoInt toHashItem() const {
-        return utils::HashItemTwoInt(fileID, pageID);
+    void add(const BufferStats& other) {
+        hits += other.hits;
+        misses += other.misses;
+        evictions += other.evictions;
+        dirtyWrites += other.dirtyWrites;
+        readBytes += other.readBytes;
+        writeBytes += other.writeBytes;
     }
 };
 
+/**
+ * @brief Snapshot of the buffer pool counters since start-up or the last reset.
+ */
+struct BufferPoolStats {
+    BufferStats total;
+    uint64_t backgroundWrites = 0;  // part of dirtyWrites done by the writer thread
+    uint64_t mappedReads = 0;       // read-only requests served from the file mapping
+    std::map<std::string, BufferStats> files;  // by path
+};
+
+/**
+ * @brief The buffer pool.
+ *
+ * The frames are split into shards; a page belongs to the shard picked by
+ * the hash of (fileID, pageID), and each shard has its own reader/writer
+ * latch, page table, replacement policy and dirty accounting. A hit only
+ * takes its shard's latch in shared mode: the access is queued in a small
+ * lossy ring and applied to the policy the next time the shard is latched
+ * exclusively (on a miss). A miss claims and pins the victim frame under the
+ * exclusive latch, then reads the page with the latch released; hits on a
+ * frame that is still loading wait for the read to finish.
+ *
+ * A background writer thread wakes up periodically (or as soon as a shard's
+ * dirty ratio crosses the configured threshold) and writes dirty frames from
+ * the cold end of each shard's policy until the ratio is back under 3/4 of
+ * the threshold, one page per latch acquisition. Victims are therefore
+ * usually clean and a miss in getPage rarely has to wait for a write. The
+ * writer never evicts and only writes pages nobody can be modifying: it skips
+ * pinned pages and pages that getPage or markPageDirty handed out during the
+ * running statement (the buffers of getPage carry no pin, so they are only
+ * known to be released once `commit` ends the statement).
+ *
+ * With a write-ahead log attached, every dirty page is logged (as a full
+ * image) before it is written to its file, and `commit` logs all pages
+ * dirtied since the last commit and makes the log durable. The LSN of the
+ * last image logged for a frame is kept per frame in memory; data pages have
+ * no spare header bytes to hold it on disk. Once the log outgrows the
+ * checkpoint size, `commit` writes back every dirty page, syncs the files and
+ * truncates the log. Once the log fails to write or sync, no logged page is
+ * written back and every later commit fails.
+ *
+ * A frame whose write-back fails stays dirty and is not evicted; the error
+ * is reported and the write is retried later.
+ *
+ * A buffer returned by getPage is only valid until a later miss evicts its
+ * frame. Callers that hold a page across other pool calls pin it with
+ * PageGuard; pinned frames are never chosen as victims.
+ */
 class BufPageManager {
 public:
-    BufPageManager(FileManager* fileMgr);
+    /**
+     * @brief Constructs the buffer manager and reserves the frame arena.
+     *
+     * @param fileMgr File manager used to read and write pages
+     * @param options Pool size, replacement policy and arena options
+     */
+    BufPageManager(FileManager* fileMgr, const BufferPoolOptions& options = BufferPoolOptions());
     ~BufPageManager();
 
     /**
@@ -34,6 +160,22 @@ public:
      */
     BufType getPage(int fileID, int pageID, int& pageIndex);
 
+    /**
+     * @brief Retrieves a page that the caller will only read.
+     *
+     * A resident page is returned from its frame exactly like getPage. When
+     * mmap reads are enabled in the FileManager, a non-resident page is served
+     * straight from the file mapping without occupying a frame; `pageIndex`
+     * is then -1, which accessPage ignores. The returned buffer must not be
+     * written.
+     *
+     * @param fileID Identifier for the file
+     * @param pageID Identifier for the page
+     * @param pageIndex Index of the page in the buffer, or -1 if mapped
+     * @return BufType Buffer representation of the page
+     */
+    BufType getPageReadOnly(int fileID, int pageID, int& pageIndex);
+
     /**
      * @brief Marks a page as accessed (should be called after accessing a page).
      *
@@ -49,24 +191,272 @@ public:
     void markPageDirty(int pageIndex);
 
     /**
-     * @brief Closes all pages and releases resources.
-     *        Must be called when exiting the program.
+     * @brief Retrieves a page and pins its frame. A pinned frame is never
+     *        chosen as a victim, so the returned buffer stays valid until the
+     *        matching unpinPage. Pins nest; each pinPage needs one unpinPage.
+     *        Prefer PageGuard over calling this directly.
+     *
+     * @param fileID Identifier for the file
+     * @param pageID Identifier for the page
+     * @param pageIndex Index of the page in the buffer
+     * @return BufType Buffer representation of the page
+     */
+    BufType pinPage(int fileID, int pageID, int& pageIndex);
+
+    /**
+     * @brief Drops one pin taken by pinPage.
+     *
+     * @param pageIndex Index of the pinned page
+     * @param dirty Whether the caller modified the page while it was pinned
+     */
+    void unpinPage(int pageIndex, bool dirty);
+
+    /**
+     * @brief Announces a sequential scan over pages [firstPageID, endPageID)
+     *        so that upcoming pages are read ahead asynchronously.
+     */
+    void beginScan(int fileID, int firstPageID, int endPageID);
+
+    /**
+     * @brief Ends a scan started with beginScan and drops unused read-ahead.
+     */
+    void endScan(int fileID);
+
+    /**
+     * @brief Writes every dirty page back to disk. Pages are written in
+     *        (file, page) order and runs of adjacent pages are coalesced into
+     *        single vectored writes. Pages stay resident and become clean.
+     *
+     * @return false if some write failed; those pages stay dirty
+     */
+    bool flushAll();
+
+    /**
+     * @brief Writes back and drops every resident page. The frame arena is
+     *        kept for reuse. Must be called when exiting the program.
      */
     void closeManager();
 
+    /**
+     * @brief Writes back and drops the resident pages of one file, e.g.
+     *        before the file is closed. Pages of other files stay cached.
+     */
+    void releaseFile(int fileID);
+
+    /**
+     * @brief Attaches the write-ahead log. Must be called before any page is
+     *        dirtied; nullptr detaches it.
+     */
+    void setLog(WriteAheadLog* log_);
+
+    /**
+     * @brief Ends a statement. With a log, logs every page dirtied since the
+     *        last commit and writes the log out, waiting until it is on disk
+     *        in STRICT mode; checkpoints when the log has grown past the
+     *        configured size. Without a log, STRICT writes back and fsyncs
+     *        every dirty page, and PERIODIC does the same once syncIntervalMs
+     *        has passed since it last did.
+     *        Buffers returned by getPage must not be written after commit.
+     *
+     * @return false if the statement's changes could not be made durable
+     */
+    bool commit();
+
+    /**
+     * @brief Writes back every dirty page, syncs the data files (unless
+     *        durability is OFF) and empties the log. No-op without a log.
+     *        The log is kept if any page could not be written back.
+     */
+    void checkpoint();
+
+    /**
+     * @brief Changes the durability mode; takes effect from the next commit.
+     */
+    void setDurability(Durability mode);
+
+    Durability getDurability() const { return durability.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Parses "off", "periodic" or "strict" (any case).
+     *
+     * @return false if the name is unknown
+     */
+    static bool parseDurability(const std::string& name, Durability& mode);
+
+    static const char* durabilityName(Durability mode);
+
+    /**
+     * @brief Number of frames in the pool.
+     */
+    int getFrameCount() const { return frameCount; }
+
+    /**
+     * @brief Number of latch partitions.
+     */
+    int getShardCount() const { return shardCount; }
+
+    /**
+     * @brief Collects the counters of every shard.
+     */
+    void getStats(BufferPoolStats& stats);
+
+    /**
+     * @brief Zeroes all counters.
+     */
+    void resetStats();
+
 private:
-    BufType allocateMemory();
-    BufType loadPage(int fileID, int pageID, int& pageIndex);
-    void releasePage(int pageIndex);
-    void flushPageToDisk(int pageIndex);
-
-    FindReplace* pageReplacementStrategy;
-    utils::BitMap* dirtyPageTracker;
-    BufType* pageBuffers;
-    FileManager* fileManager;
-    utils::HashMap<utils::HashItemTwoInt>* pageHashMap;
+    static constexpr int ACCESS_RING = 256;  // pending hits per shard, power of two
+
+    struct Shard {
+        std::shared_mutex latch;
+        std::condition_variable_any loaded;  // signalled when a frame finishes loading
+        PageTable* pageTable = nullptr;      // maps to global frame indices
+        FindReplace* policy = nullptr;       // over local indices [0, frames)
+        int firstFrame = 0;
+        int frames = 0;
+        int dirtyCount = 0;
+        int dirtyHighWater = 0;  // writer starts above this many dirty frames
+        int dirtyLowWater = 0;   // and stops at this many
+        std::atomic<int> lastAccessed{-1};  // dedups repeated touches of one frame
+        std::atomic<uint64_t> accessTick{0};
+        uint64_t drainedTick = 0;
+        std::atomic<int>* accessRing = nullptr;  // queued hits, -1 = empty
+        std::vector<int> unloggedFrames;  // dirtied since the last commit
+
+        // Counters, under the exclusive latch. Hits are counted per frame
+        // (frameHits) and folded in here when the frame changes owner.
+        std::unordered_map<int, std::pair<std::string, BufferStats>> fileStats;
+        uint64_t backgroundWrites = 0;
+        std::atomic<uint64_t> mappedReads{0};
+    };
+
+    Shard& shardOf(int fileID, int pageID) const {
+        uint64_t hash = PageTable::packKey(fileID, pageID) * 0x9E3779B97F4A7C15ULL;
+        return shards[(hash >> 32) & (shardCount - 1)];
+    }
+    Shard& shardOfFrame(int pageIndex) const { return shards[pageIndex / framesPerShard]; }
+
+    BufType lookup(Shard& shard, int fileID, int pageID, int& pageIndex);
+    BufType fetch(Shard& shard, int fileID, int pageID, int& pageIndex, bool pin);
+    void recordAccess(Shard& shard, int pageIndex);
+    void drainAccesses(Shard& shard);
+    void pinFrame(Shard& shard, int pageIndex);
+    void unpinFrame(Shard& shard, int pageIndex);
+    bool flushAllLocked(int fileID = -1);
+    void setDirty(Shard& shard, int pageIndex, bool dirty);
+    void writerLoop();
+    void syncerLoop();
+    bool syncLog() const { return durability.load(std::memory_order_relaxed) == Durability::STRICT; }
+    void trickle(Shard& shard, std::vector<int>& candidates);
+    BufferStats& statsFor(Shard& shard, int fileID);
+    void foldHits(Shard& shard, int pageIndex);
+
+    void handOut(int pageIndex) {
+        handedOut[pageIndex].store(statementEpoch.load(std::memory_order_relaxed),
+                                   std::memory_order_relaxed);
+    }
+
+    void allocateArena(bool hugePages);
+    BufType frameBuffer(int pageIndex) const {
+        return arena + static_cast<size_t>(pageIndex) * BUF_PER_PAGE;
+    }
+    int loadPage(Shard& shard, int fileID, int pageID);
+    void releasePage(Shard& shard, int pageIndex);
+    bool writeFrame(Shard& shard, int pageIndex);
+    void reportWriteFailure(int fileID, int pageID);
+    uint64_t logFrame(int pageIndex);
+
+    // Per-frame state, indexed by global frame index. Each entry is only
+    // touched under the latch of the shard that owns the frame.
+    uint8_t* dirty;
+    uint8_t* loading;  // 1 while the page is being read into the frame
+    int* pinCount;
     PageLocation* pageLocations;
-    int lastAccessedPageIndex;
+    std::atomic<uint64_t>* handedOut;  // statementEpoch of the last unpinned hand-out
+    std::atomic<uint64_t>* frameHits;  // hits since the page was loaded
+    uint8_t* unlogged;   // modified since its image was last logged
+    uint64_t* pageLSN;   // LSN of the last logged image, 0 if none
+
+    Shard* shards;
+    int shardCount;
+    int framesPerShard;
+    BufType arena;        // frameCount contiguous, page-aligned 8KB frames
+    size_t arenaBytes;
+    bool arenaMapped;     // true if the arena came from mmap
+    int frameCount;
+    FileManager* fileManager;
+    ReadAhead* readAhead;  // nullptr when read-ahead is disabled
+    WriteAheadLog* wal;    // nullptr when logging is off
+    bool lostWrites;       // a dirty page was dropped after its write failed
+    uint64_t checkpointBytes;
+
+    int writerIntervalMs;
+    std::atomic<uint64_t> statementEpoch{1};  // bumped by every commit
+    std::atomic<bool> writerStopping;
+    std::mutex writerMutex;
+    std::condition_variable writerWakeup;
+    std::thread writer;  // not started when the threshold is 0
+
+    std::atomic<Durability> durability;
+    int syncIntervalMs;
+    std::condition_variable syncerWakeup;  // shares writerMutex
+    std::thread syncer;  // started the first time PERIODIC is selected
+    std::chrono::steady_clock::time_point lastDataSync;  // PERIODIC without a log
+};
+
+/**
+ * @brief RAII pin on a buffer pool page.
+ *
+ * The page stays resident, at the same address, for the lifetime of the
+ * guard. Call markDirty after modifying it; the pin is dropped (and the page
+ * marked dirty if requested) when the guard is destroyed or released.
+ */
+class PageGuard {
+public:
+    PageGuard() : bpm(nullptr), buffer(nullptr), pageIndex(-1), dirty(false) {}
+    PageGuard(BufPageManager* bpm_, int fileID, int pageID) : bpm(bpm_), dirty(false) {
+        buffer = bpm->pinPage(fileID, pageID, pageIndex);
+    }
+    ~PageGuard() { release(); }
+
+    PageGuard(const PageGuard&) = delete;
+    PageGuard& operator=(const PageGuard&) = delete;
+    PageGuard(PageGuard&& other) noexcept
+        : bpm(other.bpm), buffer(other.buffer), pageIndex(other.pageIndex), dirty(other.dirty) {
+        other.bpm = nullptr;
+    }
+    PageGuard& operator=(PageGuard&& other) noexcept {
+        if (this != &other) {
+            release();
+            bpm = other.bpm;
+            buffer = other.buffer;
+            pageIndex = other.pageIndex;
+            dirty = other.dirty;
+            other.bpm = nullptr;
+        }
+        return *this;
+    }
+
+    BufType data() const { return buffer; }
+    int index() const { return pageIndex; }
+    void markDirty() { dirty = true; }
+
+    /**
+     * @brief Drops the pin early; the guard becomes empty.
+     */
+    void release() {
+        if (bpm != nullptr) {
+            bpm->unpinPage(pageIndex, dirty);
+            bpm = nullptr;
+        }
+    }
+
+private:
+    BufPageManager* bpm;
+    BufType buffer;
+    int pageIndex;
+    bool dirty;
 };
 
 }  // namespace fs
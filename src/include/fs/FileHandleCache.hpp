@@ -0,0 +1,88 @@
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "fs/BufPageManager.hpp"
+#include "fs/FileManager.hpp"
+
+namespace dbs {
+namespace fs {
+
+/**
+ * @brief Open-file cache shared by the record and index managers.
+ *
+ * Maps a data file path to the ID of its open descriptor. Lookups are a
+ * single hash probe; when more than `capacity` files are open, the least
+ * recently used one is closed. Closing a file only writes back and drops that
+ * file's pages from the buffer pool, so other tables stay cached.
+ */
+class FileHandleCache {
+public:
+    /**
+     * @brief Creates an empty cache.
+     *
+     * @param fileMgr File manager that owns the descriptors
+     * @param bufMgr Buffer pool holding the files' pages
+     * @param capacity_ Maximum number of files kept open
+     */
+    FileHandleCache(FileManager* fileMgr, BufPageManager* bufMgr,
+                    int capacity_ = FILE_HANDLE_CACHE_CAPACITY);
+    ~FileHandleCache();
+
+    FileHandleCache(const FileHandleCache&) = delete;
+    FileHandleCache& operator=(const FileHandleCache&) = delete;
+
+    /**
+     * @brief Returns the ID of an open file, opening it if needed.
+     *
+     * @param filePath Path of the file
+     * @return The file ID, or -1 if the file cannot be opened
+     */
+    int open(const char* filePath);
+
+    /**
+     * @brief Returns the ID of a file only if it is already open.
+     *
+     * @return The file ID, or -1 if the file is not in the cache
+     */
+    int find(const char* filePath);
+
+    /**
+     * @brief Closes a file if it is open (e.g. before deleting it).
+     */
+    void close(const char* filePath);
+
+    /**
+     * @brief Writes back the buffer pool and closes every open file.
+     */
+    void closeAll();
+
+    /**
+     * @brief Changes the number of files kept open, closing the least
+     *        recently used ones if there are too many.
+     */
+    void setCapacity(int capacity_);
+
+    int getCapacity() const { return capacity; }
+
+private:
+    struct Entry {
+        std::string path;
+        int fileID;
+    };
+
+    void closeEntry(std::list<Entry>::iterator entry);
+
+    FileManager* fm;
+    BufPageManager* bpm;
+    int capacity;
+    std::mutex mutex;
+    std::list<Entry> entries;  // most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> byPath;
+};
+
+}  // namespace fs
+}  // namespace dbs
@@ -2,11 +2,16 @@
 
 #include <iostream>
 #include <map>
+#include <string>
+#include <mutex>
+#include <shared_mutex>
 #include <cstdio>
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <vector>
 #include <dirent.h>
 
 #include "common/Config.hpp"
@@ -15,6 +20,15 @@
 namespace dbs {
 namespace fs {
 
+class WriteAheadLog;
+
+/**
+ * @brief Page-granular file access.
+ *
+ * Thread-safe: the descriptor and mapping tables are guarded by a
+ * reader/writer latch that is only held for lookups, never across I/O.
+ * Closing a file while another thread still reads it is the caller's error.
+ */
 class FileManager {
 public:
     /**
@@ -28,6 +42,18 @@ public:
      */
     bool writePage(int fileID, int pageID, BufType buffer, int offset);
 
+    /**
+     * @brief Writes `count` consecutive pages starting at `firstPageID` using
+     *        vectored positional writes (pwritev).
+     *
+     * @param fileID Identifier for the file
+     * @param firstPageID Page ID of the first buffer
+     * @param buffers One 8KB buffer per page, in page order
+     * @param count Number of pages to write
+     * @return true if every page was written, false otherwise
+     */
+    bool writePages(int fileID, int firstPageID, const BufType* buffers, int count);
+
     /**
      * @brief Reads 8KB of data (2048 4-byte integers) from a file's specified page into the buffer.
      *
@@ -39,6 +65,71 @@ public:
      */
     bool readPage(int fileID, int pageID, BufType buffer, int offset);
 
+    /**
+     * @brief Enables or disables serving read-only page requests from
+     *        shared read-only memory mappings of the files.
+     */
+    void setMmapReads(bool enabled) { mmapReads = enabled; }
+
+    bool mmapReadsEnabled() const { return mmapReads; }
+
+    /**
+     * @brief Opens files with O_DIRECT from now on, bypassing the OS page
+     *        cache so that the buffer pool is the only cache of table data.
+     *        Every buffer passed to readPage/writePage/writePages must then be
+     *        DIRECT_IO_ALIGNMENT-aligned, which buffer pool frames are. File
+     *        systems without O_DIRECT fall back to buffered I/O.
+     */
+    void setDirectIO(bool enabled) { directIO = enabled; }
+
+    bool directIOEnabled() const { return directIO; }
+
+    /**
+     * @brief Attaches the write-ahead log. deleteFile and deleteFolder then
+     *        log the removal durably before performing it, and fail without
+     *        removing anything if the log cannot be written.
+     */
+    void setLog(WriteAheadLog* log_) { wal = log_; }
+
+    /**
+     * @brief Returns a pointer to a page inside the read-only mapping of a
+     *        file, mapping or growing the mapping on demand. The pointer stays
+     *        valid until the file is closed and must never be written through.
+     *
+     * @param fileID Identifier for the file
+     * @param pageID Identifier for the page in the file
+     * @return The mapped page, or nullptr if mmap reads are disabled or the
+     *         page is not on disk yet
+     */
+    BufType mapPage(int fileID, int pageID);
+
+    /**
+     * @brief Tells the kernel that pages [firstPageID, endPageID) of a mapped
+     *        file are about to be read sequentially.
+     */
+    void adviseSequential(int fileID, int firstPageID, int endPageID);
+
+    /**
+     * @brief Flushes the data of every open file to disk (fdatasync).
+     */
+    void syncAll();
+
+    /**
+     * @brief Returns the OS file descriptor of an open file.
+     *
+     * @param fileID Identifier for the file
+     * @return The descriptor, or -1 if the file is not open
+     */
+    int getFileDescriptor(int fileID) const;
+
+    /**
+     * @brief Returns the path a file was opened with.
+     *
+     * @param fileID Identifier for the file
+     * @return The path, or an empty string if the file is not open
+     */
+    std::string getFileName(int fileID) const;
+
     /**
      * @brief Closes the specified file.
      *
@@ -103,8 +194,28 @@ public:
     bool deleteFolder(const char* folderPath);
 
 private:
+    static constexpr int IOV_MAX_PAGES = 64;  // pages per pwritev call (512KB)
+
+    struct FileMapping {
+        char* base = nullptr;
+        size_t length = 0;
+        // Earlier, smaller mappings of a growing file. They are kept until the
+        // file is closed so that pages handed out before a remap stay valid.
+        std::vector<std::pair<char*, size_t>> retired;
+    };
+
+    void unmapFile(int fileID);
+    int descriptorOf(int fileID) const;
+
     std::map<int, int> openFiles;  // Maps fileID to file descriptor
+    std::map<int, std::string> fileNames;  // Maps fileID to the path it was opened with
+    std::map<int, FileMapping> mappings;  // Read-only views, mmap read mode only
+    bool mmapReads = false;
+    bool directIO = false;
+    bool directIOWarned = false;  // the fallback warning is printed once
+    WriteAheadLog* wal = nullptr;
     uint nextFileID = 0;  // Counter for generating file IDs
+    mutable std::shared_mutex latch;  // Guards openFiles, mappings and nextFileID
 };
 
 }  // namespace fs
@@ -1,31 +1,204 @@
 #pragma once
 
-#include "utils/LinkList.hpp"
+#include <cstdint>
+#include <string>
 
 namespace dbs {
 namespace fs {
 
-class FindReplace{
+/**
+ * @brief Buffer replacement policies selectable at startup.
+ */
+enum class ReplacePolicy { LRU, CLOCK, TWO_QUEUE, LRU_K };
+
+/**
+ * @brief Interface of a buffer replacement policy over frame indices
+ *        [0, capacity).
+ *
+ * `find` picks a victim frame and treats it as freshly loaded, `access`
+ * records a hit, and `free` marks a frame as empty so it is reused first.
+ * Pinned frames are never chosen by `find`. Implementations keep all their
+ * state in arrays sized at construction, so neither hits nor misses allocate.
+ */
+class FindReplace {
 public:
-    FindReplace(int capacity_);
-    ~FindReplace();
-    int find();
-    void free(int index);
-    void access(int index);
+    explicit FindReplace(int capacity_);
+    virtual ~FindReplace();
+
+    /**
+     * @brief Chooses the frame to (re)load a page into, skipping pinned frames.
+     *
+     * @return The index of the victim frame, or -1 if every frame is pinned
+     */
+    virtual int find() = 0;
+
+    /**
+     * @brief Marks a frame as empty; it becomes the preferred victim.
+     */
+    virtual void free(int index) = 0;
+
+    /**
+     * @brief Records a hit on a frame.
+     */
+    virtual void access(int index) = 0;
+
+    /**
+     * @brief Lists up to `limit` frames from the cold end of the policy, the
+     *        likeliest next victims first. The order is exact for the queue
+     *        based policies and approximate for CLOCK and LRU-K. Does not
+     *        change the policy state; may list empty frames.
+     *
+     * @return The number of frames written to `frames`
+     */
+    virtual int coldest(int* frames, int limit) const = 0;
 
-private:
     /**
-     * @brief   
-     * 
-     * @param capacity_ 
-     * @return true 
-     * @return false 
+     * @brief Excludes a frame from victim selection until it is unpinned.
      */
-    bool updateCapacity(int capacity_);
-    utils::LinkedList<int> *list;
-    utils::LinkedListNode<int> **node;
+    void pin(int index) {
+        pinned[index] = 1;
+        ++pinnedCount;
+    }
+
+    /**
+     * @brief Makes a pinned frame a candidate victim again.
+     */
+    void unpin(int index) {
+        pinned[index] = 0;
+        --pinnedCount;
+    }
+
+    bool isPinned(int index) const { return pinned[index] != 0; }
+
+    /**
+     * @brief Creates a replacement policy instance.
+     *
+     * @param policy Which policy to build
+     * @param capacity Number of frames managed by the policy
+     */
+    static FindReplace* create(ReplacePolicy policy, int capacity);
+
+    /**
+     * @brief Parses a policy name ("lru", "clock", "2q", "lru-k").
+     *
+     * @return true if the name is recognized
+     */
+    static bool parsePolicy(const std::string& name, ReplacePolicy& policy);
+
+    static const char* policyName(ReplacePolicy policy);
+
+protected:
+    uint8_t* pinned;  // per frame, 1 while the buffer pool holds a pin
+    int pinnedCount;
     int capacity;
 };
 
+/**
+ * @brief Intrusive doubly linked queue of frame indices. The link arrays are
+ *        owned by the policy so several queues can share them.
+ */
+struct FrameQueue {
+    int head = -1, tail = -1, size = 0;
+
+    void pushHead(int index, int* prev, int* next);
+    void pushTail(int index, int* prev, int* next);
+    void remove(int index, int* prev, int* next);
+};
+
+/**
+ * @brief Least recently used: the head of the queue is the most recently
+ *        used frame, victims come from the tail.
+ */
+class LRUReplace : public FindReplace {
+public:
+    explicit LRUReplace(int capacity_);
+    ~LRUReplace() override;
+    int find() override;
+    void free(int index) override;
+    void access(int index) override;
+    int coldest(int* frames, int limit) const override;
+
+private:
+    FrameQueue queue;
+    int* prev;
+    int* next;
+};
+
+/**
+ * @brief CLOCK (second chance): one reference bit per frame and a sweeping
+ *        hand. A hit only sets the reference bit.
+ */
+class ClockReplace : public FindReplace {
+public:
+    explicit ClockReplace(int capacity_);
+    ~ClockReplace() override;
+    int find() override;
+    void free(int index) override;
+    void access(int index) override;
+    int coldest(int* frames, int limit) const override;
+
+private:
+    uint8_t* referenced;
+    uint8_t* empty;
+    int* freeFrames;  // stack of empty frames, reused before sweeping
+    int freeCount;
+    int hand;
+};
+
+/**
+ * @brief Simplified 2Q (Johnson & Shasha): newly loaded frames enter a FIFO
+ *        probation queue (A1) and are promoted to an LRU queue (Am) on their
+ *        second access, so one-off scans cannot flush the hot set.
+ */
+class TwoQueueReplace : public FindReplace {
+public:
+    explicit TwoQueueReplace(int capacity_);
+    ~TwoQueueReplace() override;
+    int find() override;
+    void free(int index) override;
+    void access(int index) override;
+    int coldest(int* frames, int limit) const override;
+
+private:
+    enum Queue : uint8_t { FREE_QUEUE, A1_QUEUE, AM_QUEUE };
+
+    FrameQueue freeQueue, a1, am;
+    int* prev;
+    int* next;
+    uint8_t* location;
+    int a1Threshold;  // A1 may hold up to this many frames before it is preferred
+
+    int coldestUnpinned(const FrameQueue& queue) const;
+};
+
+/**
+ * @brief LRU-K with K = 2: evicts the frame whose K-th most recent access is
+ *        oldest; frames seen fewer than K times are evicted first, in LRU
+ *        order. Frames are kept in an indexed binary heap.
+ */
+class LRUKReplace : public FindReplace {
+public:
+    static constexpr int K = 2;
+
+    explicit LRUKReplace(int capacity_);
+    ~LRUKReplace() override;
+    int find() override;
+    void free(int index) override;
+    void access(int index) override;
+    int coldest(int* frames, int limit) const override;
+
+private:
+    bool less(int a, int b) const;
+    void swapSlots(int i, int j);
+    void siftUp(int pos);
+    void siftDown(int pos);
+    void touch(int index);
+
+    uint64_t* history;  // K timestamps per frame, most recent first; 0 = none
+    int* heap;          // heap of frame indices ordered by `less`
+    int* position;      // frame index -> position in `heap`
+    uint64_t clock;
+};
+
 }  // namespace fs
-}  // namespace dbs
\ No newline at end of file
+}  // namespace dbs
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+
+#include "common/Config.hpp"
+
+namespace dbs {
+namespace fs {
+
+/**
+ * @brief Flat open-addressing map from a (fileID, pageID) pair to the index
+ *        of the buffer frame holding that page.
+ *
+ * Keys are packed into one 64-bit word and stored next to their frame index
+ * in a single power-of-two slot array, so a lookup is one hash plus a short
+ * linear probe over adjacent cache lines. Deletion uses backward shifting,
+ * which keeps probe sequences short without tombstones.
+ */
+class PageTable {
+public:
+    /**
+     * @brief Constructs a table able to hold at least `frameCount` entries
+     *        while keeping the load factor at or below 1/2.
+     *
+     * @param frameCount Number of buffer frames that will be indexed
+     */
+    explicit PageTable(int frameCount);
+    ~PageTable();
+
+    PageTable(const PageTable&) = delete;
+    PageTable& operator=(const PageTable&) = delete;
+
+    /**
+     * @brief Packs a (fileID, pageID) pair into the 64-bit key used by the table.
+     */
+    static uint64_t packKey(int fileID, int pageID) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(fileID)) << 32) |
+               static_cast<uint32_t>(pageID);
+    }
+
+    /**
+     * @brief Looks up the frame index of a page.
+     *
+     * @return The frame index, or -1 if the page is not resident
+     */
+    int find(int fileID, int pageID) const {
+        uint64_t key = packKey(fileID, pageID);
+        uint32_t pos = slotOf(key);
+        while (true) {
+            const Slot& slot = slots[pos];
+            if (slot.key == key) {
+                return slot.value;
+            }
+            if (slot.key == EMPTY_KEY) {
+                return -1;
+            }
+            pos = (pos + 1) & mask;
+        }
+    }
+
+    /**
+     * @brief Inserts a page, or updates its frame index if already present.
+     */
+    void insert(int fileID, int pageID, int pageIndex);
+
+    /**
+     * @brief Removes a page from the table.
+     *
+     * @return true if the page was present, false otherwise
+     */
+    bool erase(int fileID, int pageID);
+
+    /**
+     * @brief Removes every entry.
+     */
+    void clear();
+
+    int size() const { return count; }
+
+private:
+    struct Slot {
+        uint64_t key;
+        int value;
+    };
+
+    static constexpr uint64_t EMPTY_KEY = ~0ULL;  // (-1, -1) is never a real page
+
+    uint32_t slotOf(uint64_t key) const {
+        // Fibonacci hashing: the high bits of the product are well mixed.
+        return static_cast<uint32_t>((key * 0x9E3779B97F4A7C15ULL) >> shift) & mask;
+    }
+
+    Slot* slots;
+    uint32_t mask;
+    int shift;
+    int count;
+};
+
+}  // namespace fs
+}  // namespace dbs
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <deque>
+#include <vector>
+
+#include "fs/FileManager.hpp"
+
+namespace dbs {
+namespace fs {
+
+struct UringQueue;
+
+/**
+ * @brief Asynchronous sequential read-ahead for page scans.
+ *
+ * A scan registers the page range it is about to read with `beginScan`.
+ * ReadAhead then keeps up to `windowPages` upcoming pages in flight in its
+ * own staging buffers, using io_uring when the kernel allows it and a small
+ * pread thread pool otherwise. When the buffer pool misses on a page, it
+ * calls `take` to copy the staged page into the frame instead of issuing a
+ * synchronous read.
+ *
+ * Staged pages are only ever pages that were not resident when the read was
+ * submitted. Any write of a page to disk must call `invalidate` so that a
+ * staged copy never overrides newer data.
+ */
+class ReadAhead {
+public:
+    /**
+     * @brief Creates the read-ahead engine.
+     *
+     * @param fileMgr File manager that owns the file descriptors
+     * @param windowPages Number of staging buffers (pages in flight)
+     * @param allowIoUring Use io_uring if available; otherwise use threads
+     */
+    ReadAhead(FileManager* fileMgr, int windowPages, bool allowIoUring = true);
+    ~ReadAhead();
+
+    ReadAhead(const ReadAhead&) = delete;
+    ReadAhead& operator=(const ReadAhead&) = delete;
+
+    /**
+     * @brief Sets the predicate used to skip pages already in the pool.
+     */
+    void setResidencyCheck(std::function<bool(int, int)> isResident_);
+
+    /**
+     * @brief Starts prefetching pages [firstPageID, endPageID) of a file.
+     */
+    void beginScan(int fileID, int firstPageID, int endPageID);
+
+    /**
+     * @brief Stops prefetching for a file and drops its staged pages. Waits
+     *        for reads still in flight, so the file may be closed afterwards.
+     */
+    void endScan(int fileID);
+
+    /**
+     * @brief Copies a staged page into `buffer`, waiting for its read if it
+     *        is still in flight, and advances the scan window.
+     *
+     * @return true if the page was staged, false if the caller must read it
+     */
+    bool take(int fileID, int pageID, BufType buffer);
+
+    /**
+     * @brief Drops a staged copy of a page that is about to be overwritten.
+     */
+    void invalidate(int fileID, int pageID);
+
+    /**
+     * @brief Ends every scan and drops all staged pages.
+     */
+    void clear();
+
+    /**
+     * @brief Whether reads are issued through io_uring.
+     */
+    bool usingIoUring() const { return uring != nullptr; }
+
+private:
+    enum SlotState { SLOT_FREE, SLOT_INFLIGHT, SLOT_READY };
+
+    struct Slot {
+        int fileID = -1, pageID = -1;
+        int fd = -1;
+        SlotState state = SLOT_FREE;
+        ssize_t result = 0;
+    };
+
+    struct Stream {
+        int fileID;
+        int nextPageID;
+        int endPageID;
+    };
+
+    Stream* findStream(int fileID);
+    int findSlot(int fileID, int pageID) const;
+    void fill();
+    void submit(int slot);
+    void waitFor(int slot, std::unique_lock<std::mutex>& lock);
+    void release(int slot, std::unique_lock<std::mutex>& lock);
+    void reapUring();
+    void workerLoop();
+    char* slotBuffer(int slot) const {
+        return staging + static_cast<size_t>(slot) * PAGE_SIZE_BY_BYTE;
+    }
+
+    FileManager* fileManager;
+    std::function<bool(int, int)> isResident;
+    int window;
+    char* staging;
+    std::vector<Slot> slots;
+    std::vector<Stream> streams;
+    int busySlots;
+    int nextStream;  // round-robin cursor over streams
+
+    // io_uring backend (nullptr when unavailable)
+    UringQueue* uring;
+
+    // pread thread-pool backend
+    std::mutex mutex;
+    std::condition_variable completed;
+    std::condition_variable pending;
+    std::deque<int> requests;
+    std::vector<std::thread> workers;
+    bool stopping;
+};
+
+}  // namespace fs
+}  // namespace dbs
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "fs/FileManager.hpp"
+
+namespace dbs {
+namespace fs {
+
+/**
+ * @brief Redo-only write-ahead log of page images.
+ *
+ * Every record carries a log sequence number (LSN). A PAGE record holds the
+ * full 8KB image of one page of one file (identified by path, since file IDs
+ * do not survive a restart); a DELETE record holds the path of a file or
+ * folder that was removed. Replaying the records in order brings every
+ * logged page to its newest logged image.
+ *
+ * Appends only copy into an in-memory buffer. `flush` writes the buffer out
+ * and optionally fdatasyncs it; concurrent callers are grouped so that one
+ * leader writes and syncs on behalf of everyone that is waiting (group
+ * commit).
+ */
+class WriteAheadLog {
+public:
+    WriteAheadLog();
+    ~WriteAheadLog();
+
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    /**
+     * @brief Replays the log left behind by a crash, syncs the data files and
+     *        empties the log. Stops at the first torn or corrupt record.
+     *
+     * @param path Path of the log file
+     * @param fileMgr File manager used to rewrite pages and redo deletions
+     * @return Number of records replayed, 0 if there was no log
+     */
+    static int recover(const char* path, FileManager* fileMgr);
+
+    /**
+     * @brief Opens (creating if needed) the log for appending.
+     *
+     * @return true on success
+     */
+    bool open(const char* path);
+
+    /**
+     * @brief Appends the image of a page.
+     *
+     * @return The LSN of the record
+     */
+    uint64_t appendPage(const std::string& filePath, int pageID, const BufType page);
+
+    /**
+     * @brief Appends the removal of a file or folder.
+     *
+     * @return The LSN of the record
+     */
+    uint64_t appendDelete(const std::string& path);
+
+    /**
+     * @brief Makes every record up to `lsn` reach the log file, and the disk
+     *        as well if `sync` is set.
+     *
+     * @return false if the log could not be written or synced. The failure
+     *         is permanent: every later flush fails as well, and no page
+     *         logged after the last successful sync may reach its file.
+     */
+    bool flush(uint64_t lsn, bool sync);
+
+    /**
+     * @brief Flushes data files written through the page cache to disk. Uses
+     *        syncfs on the log's file system, which holds all database files.
+     */
+    void syncDataFiles();
+
+    /**
+     * @brief Discards the whole log. Only valid once every page it describes
+     *        has been written and synced (a checkpoint).
+     */
+    void truncate();
+
+    /**
+     * @brief LSN of the last appended record, 0 if none.
+     */
+    uint64_t lastLSN();
+
+    /**
+     * @brief Bytes appended since the last truncate.
+     */
+    uint64_t sizeBytes();
+
+private:
+    enum RecordType : uint32_t { RECORD_PAGE = 1, RECORD_DELETE = 2 };
+
+    struct RecordHeader {
+        uint32_t magic;
+        uint32_t type;
+        uint64_t lsn;
+        uint32_t pathLength;
+        int32_t pageID;
+        uint32_t dataLength;
+        uint32_t checksum;  // CRC-32 of the header (checksum = 0), path and data
+    };
+
+    static constexpr uint32_t RECORD_MAGIC = 0x57414c52;  // "WALR"
+
+    uint64_t append(RecordType type, const std::string& path, int pageID,
+                    const char* data, uint32_t dataLength);
+
+    int fd;
+    std::mutex mutex;
+    std::condition_variable flushed;
+    std::vector<char> pending;  // appended, not yet written
+    uint64_t nextLSN;
+    uint64_t writtenLSN;  // records up to here are in the file
+    uint64_t syncedLSN;   // records up to here are on disk
+    uint64_t logBytes;
+    uint64_t fileBytes;   // length of the log file up to the last written batch
+    bool flushing;        // a leader is writing outside the mutex
+    bool failed;          // a write or sync failed; nothing is durable any more
+};
+
+}  // namespace fs
+}  // namespace dbs
@@ -2,7 +2,9 @@
 
 #include "common/Config.hpp"
 #include "fs/BufPageManager.hpp"
+#include "fs/FileHandleCache.hpp"
 #include "fs/FileManager.hpp"
+#include "index/IndexSorter.hpp"
 #include "index/IndexType.hpp"
 #include "record/DataType.hpp"
 #include "utils/BitOperations.hpp"
@@ -16,8 +18,11 @@ class IndexManager {
      * @brief Constructor
      * @param fm_ File manager
      * @param bpm_ Buffer page manager
+     * @param files_ Open-file cache shared with the record manager; a
+     *               private one is created if nullptr
      */
-    IndexManager(fs::FileManager* fm_, fs::BufPageManager* bpm_);
+    IndexManager(fs::FileManager* fm_, fs::BufPageManager* bpm_,
+                 fs::FileHandleCache* files_ = nullptr);
 
     /**
      * @brief Destructor
@@ -39,6 +44,26 @@ class IndexManager {
      */
     bool insertIndex(const char* file_path, const IndexValue& index_value);\
 
+    /**
+     * @brief Build an index file from scratch out of sorted entries
+     *
+     * Leaves are packed left to right to `fill_percent` of a node and the
+     * internal levels are built bottom-up above them, so no node is ever
+     * split. Whatever the file held before is replaced.
+     *
+     * @param file_path Index file path
+     * @param index_key_num Number of indexed columns
+     * @param entries Every (key, rid) pair of the index; finished here
+     * @param unique Fail if two entries share a key
+     * @param fill_percent Share of a node's capacity to fill, raised to
+     *                     half full if lower
+     * @return true on success, false on a duplicate key or if the entries
+     *         could not be sorted; the index is then left empty
+     */
+    bool bulkBuildIndex(const char* file_path, int index_key_num,
+                        IndexSorter& entries, bool unique = false,
+                        int fill_percent = INDEX_BULK_FILL_PERCENT);
+
     /**
      * @brief Delete an index (deletes the first match if multiple exist)
      * @param file_path Index file path
@@ -149,6 +174,25 @@ class IndexManager {
      */
     int getFirstEmptyPageId(int file_id, bool set);
 
+    /**
+     * @brief Rewrite the bitmap pages so pages 0 to last_page_id are used
+     * @param file_id File ID
+     * @param last_page_id Last page in use
+     */
+    void writeFullBitMapPages(int file_id, int last_page_id);
+
+    /**
+     * @brief Split a level of a bulk build into nodes of per_node items;
+     *        a short last node takes items from the one before it so no
+     *        node but a lone one is under half full
+     * @param item_num Items on the level
+     * @param per_node Items per node
+     * @param b_plus_tree_m B+ tree M value
+     * @return Item count of each node, left to right
+     */
+    std::vector<int> bulkNodeSizes(size_t item_num, int per_node,
+                                   int b_plus_tree_m);
+
     /**
      * @brief Get the B+ tree M value for a given key count
      * @param index_key_num Key count
@@ -170,7 +214,6 @@ class IndexManager {
      */
     int openFile(const char* file_path);
 
-    void closeFirstFile();
     void closeFileIfOpen(const char* file_path);
 
     /**
@@ -268,9 +311,8 @@ class IndexManager {
     fs::FileManager* fm;
     fs::BufPageManager* bpm;
 
-    std::vector<char*> current_opening_file_paths;
-    std::vector<int> current_opening_file_ids;
-    const int cacheCapacity = 10;
+    fs::FileHandleCache* files;
+    bool owns_files;
 
     BPlusTreeInternalChild tmp_tree_internal_child[2];
     bool tmp_tree_underflow = false;
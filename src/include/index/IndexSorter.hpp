@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "common/Config.hpp"
+
+namespace dbs {
+namespace index {
+
+/**
+ * @brief One (key, rid) pair of an index being built. Keys past the
+ * index's key count are left at 0.
+ */
+struct IndexSortEntry {
+    int key[INDEX_KEY_MAX_NUM];
+    int pageId;
+    int slotId;
+
+    /**
+     * @brief Keys ascending, then record locations descending: the order
+     * inserting the rows one by one, in record order, leaves in the leaves
+     */
+    bool operator<(const IndexSortEntry& other) const;
+
+    bool sameKey(const IndexSortEntry& other) const;
+};
+
+/**
+ * @brief Sorts the entries of an index build.
+ *
+ * Entries are sorted in memory while they fit in `memory_bytes`; past that,
+ * each full buffer is sorted and written to a run file next to the index,
+ * and the runs are merged while the entries are read back. Run files are
+ * removed when the sorter is destroyed.
+ */
+class IndexSorter {
+public:
+    /**
+     * @param spill_prefix Run files are named `<spill_prefix>.run<N>`
+     * @param memory_bytes Bytes of entries held in memory at once
+     */
+    explicit IndexSorter(const char* spill_prefix,
+                         size_t memory_bytes = INDEX_SORT_MEMORY_BYTES);
+    ~IndexSorter();
+
+    IndexSorter(const IndexSorter&) = delete;
+    IndexSorter& operator=(const IndexSorter&) = delete;
+
+    /**
+     * @brief Adds an entry; only allowed before `finish`
+     * @param keys `key_num` key values
+     */
+    void add(int page_id, int slot_id, const int* keys, int key_num);
+
+    /**
+     * @brief Ends the input and prepares to read the entries in order
+     * @return false if a run file could not be written
+     */
+    bool finish();
+
+    /**
+     * @brief Reads the next entry in order
+     * @return false once every entry was read, or on a read error
+     */
+    bool next(IndexSortEntry& entry);
+
+    /**
+     * @brief Number of entries added
+     */
+    size_t size() const { return count; }
+
+    /**
+     * @brief Whether a run file could not be written or read back
+     */
+    bool failed() const { return ioFailed; }
+
+private:
+    struct Run {
+        FILE* file;
+        std::vector<IndexSortEntry> buffer;
+        size_t position;
+    };
+
+    void spill();
+    bool refill(Run& run);
+
+    std::string prefix;
+    size_t capacity;  // entries held in memory at once
+    size_t count;
+    bool ioFailed;
+
+    std::vector<IndexSortEntry> entries;
+    size_t position;  // next entry of `entries` when nothing was spilled
+
+    std::vector<std::string> runPaths;
+    std::vector<Run> runs;
+    std::vector<int> heap;  // runs by their current entry, smallest first
+};
+
+}  // namespace index
+}  // namespace dbs
@@ -13,10 +13,23 @@
 namespace dbs {
 namespace parser {
 
+/**
+ * @brief Runs SQL text through the ANTLR parser generated from SQL.g4 and
+ *        SQLMyVisitor.
+ *
+ * A few administrative statements are not part of SQL.g4 and are matched
+ * by `parse` before the text reaches ANTLR, each only when it is the whole
+ * input (keywords upper case, separated by whitespace):
+ *   SHOW BUFFER STATUS;  RESET BUFFER STATUS;
+ *   SET DURABILITY <off|periodic|strict>;
+ *   SET RECORD FORMAT <fixed|slotted|pax>;
+ * Adding them to the grammar requires regenerating the parser with the
+ * ANTLR tool and implementing the new visitor methods.
+ */
 class Parser {
    public:
     Parser(record::RecordManager* rm_, index::IndexManager* im_,
-           system::SystemManager* sm_);
+           system::SystemManager* sm_, fs::BufPageManager* bpm_ = nullptr);
     ~Parser();
     bool parse(std::string sSQL);
     void setOutputMode(bool mode);  // false batch
@@ -25,6 +38,7 @@ class Parser {
     record::RecordManager* rm;
     index::IndexManager* im;
     system::SystemManager* sm;
+    fs::BufPageManager* bpm;
     bool output_mode;
 };
 
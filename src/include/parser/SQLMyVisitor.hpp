@@ -1,7 +1,10 @@
 #pragma once
 
+#include <chrono>
+
 #include "antlr4-runtime.h"
 #include "condition/Condition.hpp"
+#include "fs/BufPageManager.hpp"
 #include "index/IndexManager.hpp"
 #include "parser/Parser.hpp"
 #include "parser/SQLBaseVisitor.hpp"
@@ -43,10 +46,20 @@ class SQLMyVisitor : public antlr4::SQLBaseVisitor {
    public:
     bool output_mode;
     SQLMyVisitor(record::RecordManager *rm_, index::IndexManager *im_,
-                 system::SystemManager *sm_, bool output_mode_);
+                 system::SystemManager *sm_, bool output_mode_,
+                 fs::BufPageManager *bpm_ = nullptr);
     ~SQLMyVisitor();
     std::any aggregateResult(std::any result, std::any nextResult) override;
     std::any visitProgram(antlr4::SQLParser::ProgramContext *ctx) override;
+    // prints a statement result and converts it to the success flag
+    std::any finishProgram(
+        std::any res,
+        std::chrono::high_resolution_clock::time_point start_time);
+    // Not in SQL.g4: run by Parser::parse for the statements it matches itself
+    std::any showBufferStatus();
+    std::any resetBufferStatus();
+    std::any setDurability(const std::string& mode);
+    std::any setRecordFormat(const std::string& format);
     std::any visitStatement(antlr4::SQLParser::StatementContext *ctx) override;
     std::any visitCreate_db(antlr4::SQLParser::Create_dbContext *ctx) override;
     std::any visitDrop_db(antlr4::SQLParser::Drop_dbContext *ctx) override;
@@ -134,6 +147,7 @@ class SQLMyVisitor : public antlr4::SQLBaseVisitor {
     record::RecordManager *rm;
     index::IndexManager *im;
     system::SystemManager *sm;
+    fs::BufPageManager *bpm;
 };
 
 }  // namespace parser
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "common/Config.hpp"
+#include "record/DataType.hpp"
+#include "record/RowView.hpp"
+
+namespace dbs {
+namespace record {
+
+/**
+ * @brief A CSV file mapped read-only into memory.
+ */
+class CsvFile {
+public:
+    CsvFile() : bytes(nullptr), length(0) {}
+    ~CsvFile();
+
+    CsvFile(const CsvFile&) = delete;
+    CsvFile& operator=(const CsvFile&) = delete;
+
+    /**
+     * @brief Maps the file
+     * @return false if it cannot be opened or mapped
+     */
+    bool open(const char* path);
+
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    char* bytes;
+    size_t length;
+};
+
+/**
+ * @brief A run of whole lines of a CSV text.
+ */
+struct CsvChunk {
+    const char* begin;
+    const char* end;
+};
+
+/**
+ * @brief Splits a CSV text into chunks of about `chunk_bytes`, each ending
+ * right after a newline or at the end of the text.
+ */
+std::vector<CsvChunk> splitCsvLines(const char* data, size_t size,
+                                    size_t chunk_bytes);
+
+/**
+ * @brief The rows of one chunk, encoded as stored records and kept back to
+ * back. Record ids are left at 0 for the writer to fill in.
+ */
+struct EncodedRows {
+    std::vector<unsigned char> bytes;
+    std::vector<int> offsets;  // start of each record in `bytes`
+    std::vector<int> keys;     // the requested key values of each row, row after row
+
+    int rowCount() const { return offsets.size(); }
+    int recordLength(int row) const {
+        int end = row + 1 < rowCount() ? offsets[row + 1] : bytes.size();
+        return end - offsets[row];
+    }
+    unsigned char* record(int row) { return bytes.data() + offsets[row]; }
+};
+
+/**
+ * @brief Parses every line of a chunk into a record of `layout`: a
+ * fixed-format record without slot padding when it is FIXED, a tuple when
+ * it is SLOTTED.
+ *
+ * Fields are split on `delimiter`; numbers are read with std::from_chars
+ * and dates as YYYY-MM-DD, and a field reading NULL is stored as NULL.
+ * Also collects, for each row, the values of the INT columns at
+ * `key_columns` (storage positions), INT_MIN for others and for NULLs.
+ *
+ * @return false if a line has the wrong number of fields, a value does
+ * not parse, a VARCHAR does not fit its column, or a NOT NULL column is
+ * NULL
+ */
+bool encodeCsvRows(const CsvChunk& chunk, char delimiter,
+                   const std::vector<ColumnType>& column_types,
+                   const RowLayout& layout, const std::vector<int>& key_columns,
+                   EncodedRows& rows);
+
+}  // namespace record
+}  // namespace dbs
@@ -1,19 +1,20 @@
 #pragma once
 
+#include <cstdint>
 #include <cstring>
 #include <iomanip>
 #include <iostream>
 #include <map>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <sstream>
-#include <variant>
 
 namespace dbs {
 namespace record {
 
 // Enum to define the various types of data.
-enum DataTypeIdentifier {
+enum DataTypeIdentifier : uint8_t {
     INT,
     FLOAT,
     VARCHAR, // Variable length character string
@@ -41,24 +42,83 @@ struct DateValue {
 
 /**
  * @brief Struct to represent any value of a specific data type.
+ *
+ * A 16-byte tagged union: `dataType` tells which member of `value` is set.
+ * VARCHAR values of up to SHORT_CHARS_CAPACITY bytes are stored inline;
+ * longer ones live in a reference-counted buffer shared by every copy, so
+ * copying a value never allocates. Strings are read through chars() and
+ * every value is written through the set*() methods, which release a long
+ * string the value held before.
  */
+#pragma pack(push, 4)
 struct DataValue {
-    DataTypeIdentifier dataType;
-    bool isNull;
-    // std::variant<int, double, std::string, DateValue> value;
-    struct {
+    static const int SHORT_CHARS_CAPACITY = 12;
+
+    union Payload {
+        Payload() : intValue(0) {}
         int intValue;
         double floatValue;
-        std::string charValue;
         DateValue dateValue;
+        char shortChars[SHORT_CHARS_CAPACITY];
+        struct {
+            const char* data;
+            uint32_t size;
+        } longChars;
     } value;
+    DataTypeIdentifier dataType;
+    bool isNull;
+
     void print() const;
     DataValue();
     DataValue(DataTypeIdentifier dataType_, bool isNull_);
     DataValue(DataTypeIdentifier dataType_, bool isNull_, int intValue_);
     DataValue(DataTypeIdentifier dataType_, bool isNull_, double floatValue_);
-    DataValue(DataTypeIdentifier dataType_, bool isNull_, const std::string& stringValue_);
+    DataValue(DataTypeIdentifier dataType_, bool isNull_, std::string_view stringValue_);
     DataValue(DataTypeIdentifier dataType_, bool isNull_, DateValue dateValue_);
+
+    DataValue(const DataValue& other) {
+        memcpy(static_cast<void*>(this), &other, sizeof(DataValue));
+        if (charStorage == LONG_CHARS) retainChars();
+    }
+    DataValue(DataValue&& other) noexcept {
+        memcpy(static_cast<void*>(this), &other, sizeof(DataValue));
+        other.charStorage = EMPTY_CHARS;
+    }
+    DataValue& operator=(const DataValue& other) {
+        if (this != &other) {
+            if (other.charStorage == LONG_CHARS) other.retainChars();
+            if (charStorage == LONG_CHARS) releaseChars();
+            memcpy(static_cast<void*>(this), &other, sizeof(DataValue));
+        }
+        return *this;
+    }
+    DataValue& operator=(DataValue&& other) noexcept {
+        if (this != &other) {
+            if (charStorage == LONG_CHARS) releaseChars();
+            memcpy(static_cast<void*>(this), &other, sizeof(DataValue));
+            other.charStorage = EMPTY_CHARS;
+        }
+        return *this;
+    }
+    ~DataValue() {
+        if (charStorage == LONG_CHARS) releaseChars();
+    }
+
+    /**
+     * @brief The characters of a VARCHAR value; valid while the value is
+     * neither modified nor destroyed.
+     */
+    std::string_view chars() const {
+        if (charStorage == LONG_CHARS)
+            return std::string_view(value.longChars.data, value.longChars.size);
+        return std::string_view(value.shortChars, charStorage);
+    }
+
+    void setInt(int intValue_);
+    void setFloat(double floatValue_);
+    void setDate(DateValue dateValue_);
+    void setChars(std::string_view chars_);
+
     bool isEqual(const DataValue& other) const;
     std::string toString() const;
     
@@ -81,7 +141,7 @@ struct DataValue {
                 return lhs.value.floatValue < rhs.value.floatValue;
             case DataTypeIdentifier::VARCHAR:
 
-                return lhs.value.charValue < rhs.value.charValue;
+                return lhs.chars() < rhs.chars();
             case DataTypeIdentifier::DATE:
                 return lhs.value.dateValue.year < rhs.value.dateValue.year ||
                        (lhs.value.dateValue.year == rhs.value.dateValue.year &&
@@ -103,7 +163,7 @@ struct DataValue {
             case DataTypeIdentifier::FLOAT:
                 return lhs.value.floatValue == rhs.value.floatValue;
             case DataTypeIdentifier::VARCHAR:
-                return lhs.value.charValue == rhs.value.charValue;
+                return lhs.chars() == rhs.chars();
             case DataTypeIdentifier::DATE:
                 return lhs.value.dateValue.year == rhs.value.dateValue.year &&
                        lhs.value.dateValue.month == rhs.value.dateValue.month &&
@@ -112,7 +172,23 @@ struct DataValue {
                 return false;
         }
     }
+
+   private:
+    // charStorage is the length of an inline string, or LONG_CHARS when
+    // value.longChars points into a shared buffer the value holds a
+    // reference to; it is kept whatever the data type, so a value always
+    // knows whether it has a buffer to release
+    static const uint8_t LONG_CHARS = 0xff;
+    static const uint8_t EMPTY_CHARS = 0;
+
+    uint8_t charStorage = EMPTY_CHARS;
+
+    void retainChars() const;
+    void releaseChars();
 };
+#pragma pack(pop)
+
+static_assert(sizeof(DataValue) == 16, "DataValue must stay 16 bytes");
 
 /**
  * @brief Struct to represent a collection of DataValues and their corresponding column IDs.
@@ -176,6 +252,20 @@ struct RecordLocation {
     int slotId;
 };
 
+/**
+ * @brief On-page layout of a table's records.
+ *
+ * FIXED reserves the declared width of every column in each slot; SLOTTED
+ * stores variable-length tuples reached through a per-page slot directory;
+ * PAX uses FIXED's slots but stores each column of a page contiguously.
+ */
+enum class RecordFormat { FIXED, SLOTTED, PAX };
+
+/**
+ * @brief Parses "fixed", "slotted" or "pax" (case-insensitive).
+ */
+bool parseRecordFormat(const std::string& name, RecordFormat& format);
+
 /**
  * @brief Checks if a DataItem exactly matches the given column types.
  */
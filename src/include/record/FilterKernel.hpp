@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+
+#include "common/Config.hpp"
+#include "record/DataType.hpp"
+#include "record/RowView.hpp"
+#include "system/SystemColumns.hpp"
+
+namespace dbs {
+namespace record {
+
+/**
+ * @brief One comparison of a scan constraint, prepared to run over the raw
+ * values of every slot of a page.
+ */
+struct SlotPredicate {
+    int column;                    // index in storage order
+    DataTypeIdentifier dataType;   // INT, FLOAT or DATE unless nullTest
+    system::ConstraintType op;
+    bool nullTest;                 // compares with NULL: reads only the null bitmap
+    int intKey;                    // INT value, or DATE as year << 16 | month << 8 | day
+    double floatKey;
+};
+
+/**
+ * @brief Prepares the comparisons of `constraint` on a column of a fixed or
+ * PAX table.
+ *
+ * Gives the same result as validConstraintValue. Returns false, adding
+ * nothing, if one of the comparisons needs a decoded value (VARCHAR columns,
+ * or a value whose type differs from the column's).
+ */
+bool compileSlotPredicates(const system::SearchConstraint& constraint,
+                           const RowLayout& layout, int column,
+                           std::vector<SlotPredicate>& predicates);
+
+/**
+ * @brief Clears the bit of every slot in `selection` (one bit per slot, LSB
+ * first) whose record fails `predicate`.
+ *
+ * Works on fixed and PAX pages straight from the buffer; `data` is the
+ * page's data area, after the header. Compares eight INT/DATE or four FLOAT
+ * values at a time when the CPU has AVX2.
+ */
+void filterSlots(const RowLayout& layout, const unsigned char* data,
+                 int slot_count, const SlotPredicate& predicate,
+                 unsigned int* selection);
+
+}  // namespace record
+}  // namespace dbs
@@ -4,27 +4,37 @@
 #include <sstream>
 #include <map>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "common/Config.hpp"
 #include "fs/BufPageManager.hpp"
+#include "fs/FileHandleCache.hpp"
 #include "fs/FileManager.hpp"
 #include "record/DataType.hpp"
+#include "record/RowView.hpp"
+#include "record/TableSchema.hpp"
 #include "system/SystemColumns.hpp"
 #include "utils/BitOperations.hpp"
 #include "utils/FilePath.hpp"
+#include "utils/WorkerPool.hpp"
 
 namespace dbs {
 namespace record {
 
+struct ScanFilter;
+
 class RecordManager {
    public:
     /**
      * @brief Construct a new Record Manager object
      * @param fm_
      * @param bpm_
+     * @param files_ open-file cache shared with the index manager; a private
+     *               one is created if nullptr
      */
-    RecordManager(fs::FileManager* fm_, fs::BufPageManager* bpm_);
+    RecordManager(fs::FileManager* fm_, fs::BufPageManager* bpm_,
+                  fs::FileHandleCache* files_ = nullptr);
     /**
      * @brief Destroy the Record Manager object
      */
@@ -34,14 +44,24 @@ class RecordManager {
      *
      * @param file_path 文件路径，需要保证文件所在的文件夹是存在的
      * @param column_types 所有列的类型
+     * @param format 记录格式，SLOTTED 按实际长度存储变长记录
      */
     void initializeRecordFile(const char* file_path,
-                              const std::vector<ColumnType>& column_types);
+                              const std::vector<ColumnType>& column_types,
+                              RecordFormat format = RecordFormat::FIXED);
 
     // upd 新接口↓
     void updateColumnUnique(const char* file_path, int columnId, bool unique);
     /**
-     * @brief Get the Column Types object
+     * @brief 获取记录文件的表结构（列类型、记录长度、每页槽数、各列偏移）。
+     * 第一次访问时从元数据页读取，之后返回同一个共享对象，直到 DDL 使其失效
+     *
+     * @param file_path 文件路径
+     */
+    TableSchemaPtr getSchema(const char* file_path);
+    /**
+     * @brief Get the Column Types object，复制 getSchema 中的列类型，
+     * 只读时应直接使用 getSchema
      *
      * @param file_path 文件路径
      * @param column_types 返回的vector，存储所有列的类型,
@@ -63,17 +83,23 @@ class RecordManager {
     RecordLocation insertRecord(const char* file_path, DataItem data_item);
 
     /**
-     * @brief 从零开始插入多条记录，会进行类型检查&varchar长度&null值检查，
-     * 但不会检查主键外键unique约束，这几个应该由上层模块调用元数据record和索引去检查；如果插入失败不会对数据造成影响
-     * 插入的条目必须所有值都有，default相关的问题由parser模块或系统管理模块调用getColumnType进行处理
-     * insert顺序可以不按照column_types的顺序，只需要保证data_item的columnId和column_types的columnId一致
+     * @brief 从 CSV 文件向空表批量导入记录，不检查主键外键unique约束。
+     * 文件被映射到内存，按行边界切块后由工作线程并行解析（std::from_chars），
+     * 每行直接编码为存储格式，再整页写入缓冲池；定长与 PAX 格式的各页也并行写入。
+     * 文件有格式错误时不写入任何记录
      *
      * @param file_path 文件路径
-     * @param data_items 插入的数据，需要保证数据的合法性
-     * @return RecordLocation, -1, -1表示插入失败
+     * @param csv_path CSV 文件路径
+     * @param record_locations 若不为空，按行序返回每条记录的位置
+     * @param key_column_ids 需要返回取值的 INT 列（如索引列）
+     * @param keys 若不为空，按行序返回每行 key_column_ids 各列的值，NULL 为 INT_MIN
+     * @return 每页记录数，-1 表示导入失败
      */
-    int insertRecordsToEmptyRecord(const char* file_path, const char* csv_path,
-                                   const char* delimeter, bool output);
+    int insertRecordsToEmptyRecord(
+        const char* file_path, const char* csv_path, const char* delimeter,
+        bool output, std::vector<RecordLocation>* record_locations = nullptr,
+        const std::vector<int>& key_column_ids = std::vector<int>(),
+        std::vector<int>* keys = nullptr);
 
     int getTotalPageNum(const char* file_path);
     /**
@@ -111,10 +137,21 @@ class RecordManager {
     bool getRecord(const char* file_path, const RecordLocation& record_location,
                    DataItem& data_item);
 
+    /**
+     * @brief Scans the table for the records that satisfy all constraints.
+     * INT/FLOAT/DATE comparisons on fixed and PAX tables are evaluated over
+     * the raw page data first; only the slots that pass are decoded.
+     * Tables of two morsels (SCAN_MORSEL_PAGES pages each) or more are
+     * scanned by the scan worker pool, one morsel per task; rows come back
+     * in page order either way.
+     *
+     * @param column_mask columns to decode; see ColumnMask
+     */
     void getAllRecordWithConstraint(
         const char* file_path, std::vector<DataItem>& data_items,
         std::vector<RecordLocation>& record_locations,
-        const std::vector<system::SearchConstraint>& constraints);
+        const std::vector<system::SearchConstraint>& constraints,
+        const ColumnMask& column_mask = ColumnMask());
 
     /**
      * @brief Get the Records object （vector的形式，多个）
@@ -133,13 +170,16 @@ class RecordManager {
      * @param file_path 文件路径
      * @param data_items 返回的数据
      * @param record_locations 返回的位置
+     * @param column_mask 需要解码的列，见 ColumnMask
      */
     void getAllRecords(const char* file_path, std::vector<DataItem>& data_items,
-                       std::vector<RecordLocation>& record_locations);
+                       std::vector<RecordLocation>& record_locations,
+                       const ColumnMask& column_mask = ColumnMask());
 
     void getRecordsInPageRange(const char* file_path,
                                std::vector<DataItem>& data_items, int low_page,
-                               int upper_page);
+                               int upper_page,
+                               const ColumnMask& column_mask = ColumnMask());
 
     /**
      * @brief delete the record file
@@ -156,15 +196,126 @@ class RecordManager {
     void closeAllCurrentFile();
 
     /**
-     * @brief clean all current column types
+     * @brief Drops every cached schema; the next getSchema of each file
+     * reads its meta page again
+     */
+    void invalidateAllSchemas();
+
+    /**
+     * @brief Sets the number of threads of parallel table scans and CSV
+     * loads, the caller included; 0 uses one per hardware thread and 1
+     * works serially
      */
-    void cleanAllCurrentColumnTypes();
+    void setScanThreads(int threads);
 
     int getAllRecordWithConstraintSaveFile(
         const char* file_path, const char* file_path_save,
         const std::vector<system::SearchConstraint>& constraints);
 
    private:
+    /**
+     * @brief Reads the schema of a record file from its meta page
+     */
+    TableSchemaPtr loadSchema(const char* file_path);
+
+    RecordLayout getLayout(const BufType meta,
+                           const std::vector<ColumnType>& column_types);
+
+    /**
+     * @brief Writes a record into a FIXED or PAX slot and marks it occupied
+     */
+    void writeSlot(BufType b, int slot_id, const RecordLayout& layout,
+                   int record_id, const DataItem& data_item,
+                   const std::vector<ColumnType>& column_types);
+
+    /**
+     * @brief setSlotItem for PAX pages: each value goes to its column's
+     * minipage
+     */
+    void setPaxItem(BufType b, int slot_id, const RecordLayout& layout,
+                    int record_id, const DataItem& data_item,
+                    const std::vector<ColumnType>& column_types);
+
+    /**
+     * @brief Whether a data page can take another record of the table
+     */
+    bool pageHasRoom(const BufType b, const RecordLayout& layout);
+
+    /**
+     * @brief Returns the page to scan; slotted pages stay pinned in `pin`
+     * because a forwarded record loads a second page
+     * @param shared the scan runs on several threads, so every page is
+     * pinned: another thread's miss could otherwise evict it
+     */
+    BufType scanPage(int file_id, int page_id, const RecordLayout& layout,
+                     fs::PageGuard& pin, bool shared = false);
+
+    /**
+     * @brief Appends the rows of pages [low_page, upper_page) that pass
+     * `filter`, and their locations. Only touches the buffer pool, so
+     * several ranges of one file can be scanned at once with `shared` set.
+     */
+    void scanPageRange(int file_id, const RecordLayout& layout,
+                       const RowLayout& row_layout, const ScanFilter& filter,
+                       const ColumnMask& column_mask, int low_page,
+                       int upper_page, bool shared,
+                       std::vector<DataItem>& data_items,
+                       std::vector<RecordLocation>& record_locations);
+
+    /**
+     * @brief Locates the record in an occupied slot of either format,
+     * following a forwarded slotted record
+     * @param forwarded keeps the page of a forwarded record pinned
+     * @return nullptr for the moved-in copy of a forwarded record, which is
+     * only reachable through its original slot
+     */
+    const unsigned char* slotRecord(int file_id, const BufType b, int slot_id,
+                                    const RecordLayout& layout,
+                                    fs::PageGuard& forwarded);
+
+    /**
+     * @brief Reads the record in an occupied slot into a DataItem
+     * @return false where slotRecord returns nullptr
+     */
+    bool readSlot(int file_id, const BufType b, int slot_id,
+                  const RecordLayout& layout, const RowLayout& row_layout,
+                  DataItem& data_item,
+                  const ColumnMask& column_mask = ColumnMask());
+
+    /**
+     * @brief Encodes a record for a slotted page: record id, null bitmap (one
+     * bit per column), then the non-null values; VARCHAR takes 2 + length
+     * bytes
+     */
+    void encodeSlottedItem(int record_id, const DataItem& data_item,
+                           const std::vector<ColumnType>& column_types,
+                           std::vector<unsigned char>& tuple);
+
+    /**
+     * @brief Stores a slotted tuple in the first page with room (via the
+     * free-space map), appending a page if there is none
+     * @param flags directory flags of the new slot (SLOTTED_MOVED_IN)
+     */
+    RecordLocation placeSlottedTuple(int file_id, int fsm_id, BufType meta_b,
+                                     const RecordLayout& layout,
+                                     const std::vector<unsigned char>& tuple,
+                                     unsigned int flags);
+
+    bool isSlottedFile(const char* file_path);
+
+    /**
+     * @brief updateRecord for slotted files; data_item is the full new row
+     */
+    bool updateSlottedRecord(const char* file_path,
+                             const RecordLocation& record_location,
+                             DataItem data_item);
+
+    /**
+     * @brief Frees the moved-in copy of a forwarded record
+     */
+    void releaseSlottedTuple(int file_id, int fsm_id, const RecordLayout& layout,
+                             const RecordLocation& location);
+
     /**
      * @brief sort the data item according to column types
      * @param column_types
@@ -185,31 +336,71 @@ class RecordManager {
                      int null_bitmap_buf_size, const DataItem& data_item,
                      const std::vector<ColumnType>& column_types);
 
-    DataItem getSlotItem(BufType b, int slot_id, int slot_length,
-                         int null_bitmap_buf_size,
-                         const std::vector<ColumnType>& column_types);
-    // get the slot item
     int dataItemLength(const std::vector<ColumnType>& column_types,
                        int null_bitmap_size);
 
-    void closeFirstFile();
     void closeFileIfExist(const char* file_path);
 
-    void cleanFirstColumnTypes();
-    void cleanColumnTypesIfExist(const char* file_path);
+    /**
+     * @brief Drops the cached schema of a file whose meta page changed
+     */
+    void invalidateSchema(const char* file_path);
 
     int openFile(const char* file_path);
 
+    /*
+     * Free-space map: a sidecar file (file_path + FREE_SPACE_MAP_SUFFIX)
+     * with one bit per data page, set while the page has a free slot.
+     * Page 0 holds [0] FREE_SPACE_MAP_MAGIC, [1] the append cursor (every
+     * page below it is full) and [2] the number of data pages covered; the
+     * bitmap for data page p is bit (p - 1) % BIT_PER_PAGE of map page
+     * (p - 1) / BIT_PER_PAGE + 1.
+     */
+    std::string freeSpaceMapPath(const char* file_path) const;
+
+    /**
+     * @brief Opens the free-space map of a record file, creating an empty
+     * (invalid) one if it does not exist
+     * @return file id of the map
+     */
+    int openFreeSpaceMap(const char* file_path);
+
+    /**
+     * @brief Rebuilds the map from the slot bitmaps of the data pages if it
+     * is invalid or does not cover page_num pages (older files, or a bulk
+     * load that failed half-way)
+     */
+    void validateFreeSpaceMap(int fsm_id, int file_id, int page_num,
+                              const RecordLayout& layout);
+
+    /**
+     * @brief Resets the map to cover page_num pages that are all full, except
+     * the last one if last_page_free
+     */
+    void resetFreeSpaceMap(int fsm_id, int page_num, bool last_page_free);
+
+    /**
+     * @brief First page at or after the append cursor that has a free slot
+     * @return page id, or -1 if every page is full
+     */
+    int findFreePage(int fsm_id, int page_num);
+
+    void setPageFree(int fsm_id, int page_id, bool free);
+
+    /**
+     * @brief Extends the map by the newly appended data page page_id
+     */
+    void appendFreeSpaceMapPage(int fsm_id, int page_id, bool free);
+
     fs::FileManager* fm;
     fs::BufPageManager* bpm;
 
-    std::vector<char*> current_opening_file_paths;
-    std::vector<int> current_opening_file_ids;
-    const int cacheCapacity = 10;
+    fs::FileHandleCache* files;
+    bool owns_files;
+
+    utils::WorkerPool* scan_workers;
 
-    std::vector<char*> current_column_types_file_paths;
-    std::vector<std::vector<ColumnType>> current_column_types;
-    const int columnCacheCapacity = 10;
+    std::unordered_map<std::string, TableSchemaPtr> schemas;  // by file path
 };
 
 }  // namespace record
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "common/Config.hpp"
+#include "record/DataType.hpp"
+
+namespace dbs {
+namespace record {
+
+/**
+ * @brief Where a table's column values sit inside a stored record.
+ *
+ * Fixed and slotted records start with the record id (4 bytes) and a null
+ * bitmap whose bit c (LSB first) is in byte 4 + c / 8. Fixed-format records
+ * keep every value at a constant offset, computed once here; slotted tuples
+ * pack non-null values, so their offsets are found per row by RowView.
+ *
+ * PAX pages split the fixed-format record into minipages: the record ids of
+ * all slots, then their null bitmaps, then each column's values, one
+ * minipage per column. Offsets are then relative to the page's data area
+ * and value c of slot s is at column_offsets[c] + s * column_widths[c].
+ */
+struct RowLayout {
+    RecordFormat format;
+    int values_offset;                  // first value, in bytes from the record start
+    int items_per_page;                 // PAX: slots per page
+    int null_bytes;                     // PAX: null bitmap bytes per slot
+    int slot_stride;                    // fixed format: bytes from one slot to the next
+    std::vector<int> column_offsets;    // fixed and PAX formats: offset of each value
+    std::vector<int> column_widths;     // fixed and PAX formats: bytes per value
+    std::vector<DataTypeIdentifier> data_types;
+    std::vector<int> column_ids;
+
+    /**
+     * @param column_types columns in storage order
+     * @param null_bitmap_buf_size fixed and PAX formats: words reserved for
+     * the null bitmap
+     * @param items_per_page_ PAX format: slots per page
+     * @param slot_stride_ fixed format: slot size, which may exceed the record
+     */
+    RowLayout(const std::vector<ColumnType>& column_types, RecordFormat format_,
+              int null_bitmap_buf_size, int items_per_page_, int slot_stride_);
+
+    int columnCount() const { return data_types.size(); }
+};
+
+/**
+ * @brief Columns a scan has to decode, indexed by column id; an empty mask
+ * selects every column. Columns left out are returned as NULL placeholders
+ * so that values stay indexed by column.
+ */
+typedef std::vector<bool> ColumnMask;
+
+/**
+ * @brief Read-only view of one record in a buffer page.
+ *
+ * Values are decoded on demand straight from the page, so a scan can test a
+ * row's constraints without building a DataItem and only materialize the
+ * rows that qualify. The page must stay in the buffer pool (pinned, or not
+ * yet evicted) while the view is used.
+ */
+class RowView {
+public:
+    /**
+     * @param record_ start of the record; for PAX, the page's data area
+     * @param slot_ PAX format: the record's slot in the page
+     */
+    RowView(const RowLayout& layout_, const unsigned char* record_, int slot_)
+        : layout(&layout_), record(record_), slot(slot_), walked(0) {}
+
+    unsigned int recordId() const;
+    bool isNull(int column) const;
+    int getInt(int column) const;
+    double getFloat(int column) const;
+    std::string_view getVarchar(int column) const;
+    DateValue getDate(int column) const;
+
+    /**
+     * @brief Decodes one column into `value`, reusing its string storage
+     */
+    void getValue(int column, DataValue& value) const;
+
+    /**
+     * @brief Builds the full row, as getRecord returns it
+     */
+    DataItem materialize() const;
+
+    /**
+     * @brief Builds the row, decoding only the columns in `column_mask`
+     */
+    DataItem materialize(const ColumnMask& column_mask) const;
+
+private:
+    const unsigned char* valueAt(int column) const;
+
+    const RowLayout* layout;
+    const unsigned char* record;
+    int slot;
+    // Slotted tuples: offsets of the first `walked` columns
+    mutable int walked;
+    mutable std::array<uint16_t, MAX_COLUMN_NUM + 1> offsets;
+};
+
+}  // namespace record
+}  // namespace dbs
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "record/DataType.hpp"
+#include "record/RowView.hpp"
+
+namespace dbs {
+namespace record {
+
+/**
+ * @brief Layout of a record file, read from its meta page.
+ */
+struct RecordLayout {
+    bool slotted;
+    bool pax;                // FIXED slots, values stored column by column
+    int null_bitmap_buf_size;
+    int data_item_length;    // slot size (FIXED) or longest tuple (SLOTTED), in bytes
+    int data_item_per_page;  // slots per data page
+    int min_item_length;     // shortest possible record, in bytes
+};
+
+/**
+ * @brief The columns of a record file and everything derived from them:
+ * record length, slots per page and where each value is stored.
+ *
+ * A schema is built once from the meta page and never changes. DDL that
+ * rewrites the meta page makes the RecordManager drop its copy, so the next
+ * caller gets a new schema, while anyone still holding the old one keeps a
+ * consistent view of the table as it was.
+ */
+struct TableSchema {
+    TableSchema(std::vector<ColumnType> columns_, const RecordLayout& layout_);
+
+    const std::vector<ColumnType> columns;  // in storage order
+    const RecordLayout layout;
+    const RowLayout row_layout;  // offset and width of each stored value
+
+    RecordFormat format() const { return row_layout.format; }
+};
+
+/**
+ * @brief Shared handle to a schema; the schema lives while anyone holds it.
+ */
+typedef std::shared_ptr<const TableSchema> TableSchemaPtr;
+
+}  // namespace record
+}  // namespace dbs
@@ -87,6 +87,10 @@ bool mergeConstraints(std::vector<SearchConstraint>& constraints);
 bool validConstraint(const SearchConstraint& constraint,
                      const record::DataItem& item);
 
+// 对单个列值检查约束，调用方已确认该值属于 constraint.columnId 对应的列
+bool validConstraintValue(const SearchConstraint& constraint,
+                          const record::DataValue& value);
+
 void filterConstraints(
     const std::vector<SearchConstraint>& constraints,
     const std::vector<record::DataItem>& data_items,
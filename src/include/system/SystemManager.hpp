@@ -4,6 +4,7 @@
 #include <fstream>  // File operations
 #include <string>  // String operations
 #include <set>      // To handle sets of unique elements
+#include <unordered_map>  // Path cache
 #include <vector>   // To handle dynamic arrays (vectors)
 #include <sstream>  // For stringstream operations  
 #include <assert.h> // For assertions and debugging
@@ -97,6 +98,11 @@ class SystemManager {
                      const std::vector<std::string>& primary_keys,
                      const std::vector<ForeignKeyInputInfo>& foreign_keys);
 
+    /**
+     * @brief Sets the record format of tables created from now on
+     */
+    void setRecordFormat(record::RecordFormat format) { tableRecordFormat = format; }
+
     // Methods for managing foreign keys in tables
     bool addForeignKey(const char* table_name,
                        const ForeignKeyInfo& new_foreign_key);
@@ -112,6 +118,15 @@ class SystemManager {
     bool getTableColumnTypes(int table_id,
                              std::vector<record::ColumnType>& column_types);
 
+    /**
+     * @brief Retrieves the shared schema of a table, without copying its
+     * column types
+     *
+     * @param table_id The unique ID of the table
+     * @return The schema, valid until the caller lets go of it
+     */
+    record::TableSchemaPtr getTableSchema(int table_id);
+
     // Method to get primary keys for a table
     bool getTablePrimaryKeys(int table_id, std::set<int>& primary_keys);
 
@@ -274,9 +289,10 @@ class SystemManager {
      */
     bool searchRowsInTable(int table_id, std::vector<SearchConstraint>& constraints,
                 std::vector<record::DataItem>& result_datas,
-                std::vector<record::ColumnType>& column_types,
+                record::TableSchemaPtr& schema,
                 std::vector<record::RecordLocation>& record_location_results,
-                int sort_by);
+                int sort_by,
+                const record::ColumnMask& column_mask = record::ColumnMask());
     /**
      * @brief Drops a unique constraint from a table
      *
@@ -349,12 +365,21 @@ class SystemManager {
                      std::vector<std::pair<int, std::vector<int>>>& index_ids,
                      std::vector<std::string>& index_names);
 
+    /**
+     * @brief Returns the path of a database folder (table_id = -1), a table
+     *        folder (index_id = -1) or an index file, building it only the
+     *        first time the ids are seen
+     */
+    const std::string& cachedPath(int database_id, int table_id, int index_id) const;
+
     fs::FileManager* fm;   // Pointer to the FileManager instance
     record::RecordManager* rm;  // Pointer to the RecordManager instance
     index::IndexManager* im;  // Pointer to the IndexManager instance
 
     int currentDatabaseId;  // ID of the current active database
     std::string currentDatabaseName;  // Name of the current active database
+    record::RecordFormat tableRecordFormat;  // Record format of new tables
+    mutable std::unordered_map<uint64_t, std::string> path_cache;  // Keyed by packed (database, table, index) ids
 };
 
 }  // namespace system
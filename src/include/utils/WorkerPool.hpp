@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dbs {
+namespace utils {
+
+/**
+ * @brief A fixed set of threads that split a batch of numbered tasks.
+ *
+ * `run` hands tasks out one at a time from a shared counter, so a thread
+ * that finishes early simply takes the next one; the calling thread works
+ * on the batch too. One batch runs at a time.
+ */
+class WorkerPool {
+public:
+    /**
+     * @brief Starts the pool.
+     *
+     * @param threads Threads working on a batch, the caller included; 0
+     *                picks one per hardware thread
+     */
+    explicit WorkerPool(int threads = 0);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /**
+     * @brief Calls `task(i)` for every i in [0, taskCount) and returns once
+     *        all calls are done. Calls run concurrently and in no set order.
+     */
+    void run(int taskCount, const std::function<void(int)>& task);
+
+    /**
+     * @brief Threads working on a batch, the caller included.
+     */
+    int size() const { return static_cast<int>(workers.size()) + 1; }
+
+private:
+    void workerLoop();
+    void work();
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable started;   // a batch was posted, or stopping
+    std::condition_variable finished;  // a worker left the current batch
+    const std::function<void(int)>* batch;
+    int batchSize;
+    std::atomic<int> nextTask;
+    unsigned long long generation;  // batches posted so far
+    int busyWorkers;
+    bool stopping;
+};
+
+}  // namespace utils
+}  // namespace dbs
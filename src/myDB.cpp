@@ -1,10 +1,13 @@
+#include <cstdlib>
 #include <cstring>
 #include <fstream>
 #include <iostream>
 
 #include "common/Color.hpp"
 #include "fs/BufPageManager.hpp"
+#include "fs/FileHandleCache.hpp"
 #include "fs/FileManager.hpp"
+#include "fs/WriteAheadLog.hpp"
 #include "index/IndexManager.hpp"
 #include "parser/Parser.hpp"
 #include "record/RecordManager.hpp"
@@ -16,6 +19,14 @@ int main(int argc, char *argv[]) {
     std::string file_path = "";
     std::string table_name = "";
     std::string initDatabaseName = "";
+    dbs::fs::BufferPoolOptions poolOptions;
+    bool mmapReads = false;
+    bool useWal = true;
+    bool durabilityGiven = false;
+    bool directIO = false;
+    int openFiles = FILE_HANDLE_CACHE_CAPACITY;
+    dbs::record::RecordFormat recordFormat = dbs::record::RecordFormat::FIXED;
+    int scanThreads = 0;  // 0 表示按硬件线程数
     for (int i = 1; i < argc; i++) {
         auto param = std::string(argv[i]);
         if (param == "--init") { // initialization
@@ -34,6 +45,93 @@ int main(int argc, char *argv[]) {
         // 相当于已经执行了 USE <db>
             initDatabaseName = std::string(argv[++i]);
         } 
+        else if (param == "--replace-policy") { // --replace-policy <lru|clock|2q|lru-k>：缓存页替换策略
+            std::string policy = i + 1 < argc ? std::string(argv[++i]) : "";
+            if (!dbs::fs::FindReplace::parsePolicy(policy, poolOptions.policy)) {
+                std::cout << "Unknown replace policy: " << policy << std::endl;
+                return -1;
+            }
+        }
+        else if (param == "--buffer-pool-mb") { // --buffer-pool-mb <n>：缓存池大小（MB）
+            int megabytes = i + 1 < argc ? std::atoi(argv[++i]) : 0;
+            if (megabytes < 1) {
+                std::cout << "Invalid buffer pool size, expected at least 1 MB" << std::endl;
+                return -1;
+            }
+            poolOptions.frameCount = dbs::fs::BufferPoolOptions::framesForMegabytes(megabytes);
+        }
+        else if (param == "--huge-pages") { // --huge-pages：缓存池使用透明大页
+            poolOptions.hugePages = true;
+        }
+        else if (param == "--read-ahead") { // --read-ahead <pages>：顺序扫描预读窗口（页），0 表示关闭
+            poolOptions.readAheadPages = i + 1 < argc ? std::atoi(argv[++i]) : 0;
+        }
+        else if (param == "--no-io-uring") { // --no-io-uring：预读使用线程池 pread 而非 io_uring
+            poolOptions.ioUring = false;
+        }
+        else if (param == "--dirty-threshold") { // --dirty-threshold <percent>：脏页比例超过该值时后台线程开始写回，0 表示关闭后台写回
+            int percent = i + 1 < argc ? std::atoi(argv[++i]) : -1;
+            if (percent < 0 || percent > 100) {
+                std::cout << "Invalid dirty threshold, expected 0-100" << std::endl;
+                return -1;
+            }
+            poolOptions.dirtyThresholdPercent = percent;
+        }
+        else if (param == "--buffer-pool-shards") { // --buffer-pool-shards <n>：缓存池分片数（2 的幂），默认按硬件线程数
+            int shards = i + 1 < argc ? std::atoi(argv[++i]) : 0;
+            if (shards < 1) {
+                std::cout << "Invalid shard count, expected at least 1" << std::endl;
+                return -1;
+            }
+            poolOptions.shards = shards;
+        }
+        else if (param == "--mmap-reads") { // --mmap-reads：只读页请求直接从文件映射读取
+            mmapReads = true;
+        }
+        else if (param == "--direct-io") { // --direct-io：数据文件使用 O_DIRECT 读写，绕过操作系统页缓存
+            directIO = true;
+        }
+        else if (param == "--durability") { // --durability <off|periodic|strict>：落盘策略，off 不调用 fsync，periodic 每隔 --sync-interval-ms 毫秒 fsync 一次，strict 每条语句结束时 fsync；交互模式默认 strict，批处理模式默认 periodic
+            std::string mode = i + 1 < argc ? std::string(argv[++i]) : "";
+            if (!dbs::fs::BufPageManager::parseDurability(mode, poolOptions.durability)) {
+                std::cout << "Unknown durability mode: " << mode << std::endl;
+                return -1;
+            }
+            durabilityGiven = true;
+        }
+        else if (param == "--sync-interval-ms") { // --sync-interval-ms <n>：periodic 模式下 fsync 的间隔（毫秒）
+            int interval = i + 1 < argc ? std::atoi(argv[++i]) : 0;
+            if (interval < 1) {
+                std::cout << "Invalid sync interval, expected at least 1 ms" << std::endl;
+                return -1;
+            }
+            poolOptions.syncIntervalMs = interval;
+        }
+        else if (param == "--open-files") { // --open-files <n>：同时保持打开的数据文件数上限，超出时关闭最久未使用的文件
+            openFiles = i + 1 < argc ? std::atoi(argv[++i]) : 0;
+            if (openFiles < MIN_FILE_HANDLE_CACHE_CAPACITY) {
+                std::cout << "Invalid open file limit, expected at least "
+                          << MIN_FILE_HANDLE_CACHE_CAPACITY << std::endl;
+                return -1;
+            }
+        }
+        else if (param == "--record-format") { // --record-format <fixed|slotted|pax>：新建表的记录格式，slotted 按实际长度存储变长记录，pax 在页内按列连续存放
+            std::string format = i + 1 < argc ? std::string(argv[++i]) : "";
+            if (!dbs::record::parseRecordFormat(format, recordFormat)) {
+                std::cout << "Unknown record format: " << format << std::endl;
+                return -1;
+            }
+        }
+        else if (param == "--scan-threads") { // --scan-threads <n>：无索引可用时并行扫描表、LOAD DATA 并行解析的线程数，默认按硬件线程数，1 表示单线程
+            scanThreads = i + 1 < argc ? std::atoi(argv[++i]) : 0;
+            if (scanThreads < 1) {
+                std::cout << "Invalid scan thread count, expected at least 1" << std::endl;
+                return -1;
+            }
+        }
+        else if (param == "--no-wal") { // --no-wal：关闭预写日志（崩溃后不保证数据完整）
+            useWal = false;
+        }
         else {
             std::cout  << "Unknown param: " << param << std::endl;
             i++;
@@ -41,9 +139,15 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    if (batchMode && !durabilityGiven) {
+        // 批处理模式的输入是整份脚本，逐条 fdatasync 会让导入慢数倍；
+        // 预写日志在语句结束时已写入文件，进程崩溃不丢失已确认的语句，
+        // 只有断电时可能丢失最近 --sync-interval-ms 毫秒内确认的语句
+        poolOptions.durability = dbs::fs::Durability::PERIODIC;
+    }
     if (init) {
         dbs::fs::FileManager *fm = new dbs::fs::FileManager();
-        dbs::fs::BufPageManager *bpm = new dbs::fs::BufPageManager(fm);
+        dbs::fs::BufPageManager *bpm = new dbs::fs::BufPageManager(fm, poolOptions);
         dbs::record::RecordManager *rm =
             new dbs::record::RecordManager(fm, bpm);
         dbs::index::IndexManager *im = new dbs::index::IndexManager(fm, bpm);
@@ -58,12 +162,32 @@ int main(int argc, char *argv[]) {
         return 0;
     }
     dbs::fs::FileManager *fm = new dbs::fs::FileManager();
-    dbs::fs::BufPageManager *bpm = new dbs::fs::BufPageManager(fm);
-    dbs::record::RecordManager *rm = new dbs::record::RecordManager(fm, bpm);
-    dbs::index::IndexManager *im = new dbs::index::IndexManager(fm, bpm);
+    fm->setMmapReads(mmapReads);
+    fm->setDirectIO(directIO);
+    if (useWal) {
+        // 重放上次崩溃遗留的预写日志
+        dbs::fs::WriteAheadLog::recover(WAL_FILE_PATH, fm);
+    }
+    dbs::fs::BufPageManager *bpm = new dbs::fs::BufPageManager(fm, poolOptions);
+    dbs::fs::FileHandleCache *files = new dbs::fs::FileHandleCache(fm, bpm, openFiles);
+    dbs::record::RecordManager *rm = new dbs::record::RecordManager(fm, bpm, files);
+    if (scanThreads > 0) rm->setScanThreads(scanThreads);
+    dbs::index::IndexManager *im = new dbs::index::IndexManager(fm, bpm, files);
     dbs::system::SystemManager *sm = new dbs::system::SystemManager(fm, rm, im);
-    dbs::parser::Parser *parser = new dbs::parser::Parser(rm, im, sm);
+    dbs::parser::Parser *parser = new dbs::parser::Parser(rm, im, sm, bpm);
     sm->initializeSystem();
+    sm->setRecordFormat(recordFormat);
+    dbs::fs::WriteAheadLog *wal = nullptr;
+    if (useWal) {
+        wal = new dbs::fs::WriteAheadLog();
+        if (wal->open(WAL_FILE_PATH)) {
+            bpm->setLog(wal);
+            fm->setLog(wal);
+        } else {
+            delete wal;
+            wal = nullptr;
+        }
+    }
     if (initDatabaseName != "") {
         sm->setActiveDatabase(initDatabaseName.c_str());
     }
@@ -71,6 +195,7 @@ int main(int argc, char *argv[]) {
         std::string input = "LOAD DATA INFILE '" + file_path + "' INTO TABLE " +
                             table_name + " FIELDS TERMINATED BY ',';\n";
         auto result = parser->parse(input.c_str());
+        if (!bpm->commit()) result = false;
         std::cout << Color::OKGREEN << "@ " << (result ? "Success" : "Fail") << Color::ENDC << std::endl;
     }
     if (batchMode) {
@@ -82,6 +207,7 @@ int main(int argc, char *argv[]) {
                 break;
             }
             auto result = parser->parse(input);
+            if (!bpm->commit()) result = false;  // 未能落盘的语句不能报告成功
             // print type of result
             std::cout << "@ " << (result ? "success" : "fail") << std::endl; //dont use color here it will be slow excruciatingly slow
         }
@@ -103,9 +229,11 @@ int main(int argc, char *argv[]) {
                 std::getline(std::cin, input_continue, '\n');
                 input = input + input_continue;
             }
-            auto result = parser->parse(input);
-            // update thee active database  
-            bpm->closeManager(); 
+            parser->parse(input);
+            if (!bpm->commit()) {
+                std::cout << Color::FAIL << "!ERROR: the statement could not be made durable"
+                          << Color::ENDC << std::endl;
+            }
             std::cout << Color::PINK << "mySQL ("<< sm->getActiveDatabaseName() << ") >> " << Color::ENDC << std::flush;
             // std::cout << "mySQL>> " << std::flush;
         }
@@ -115,6 +243,11 @@ int main(int argc, char *argv[]) {
     delete sm;
     delete im;
     delete rm;
+    delete files;
+    bpm->checkpoint();
+    bpm->setLog(nullptr);
+    fm->setLog(nullptr);
+    delete wal;
     delete bpm;
     delete fm;
 
@@ -1,104 +1,770 @@
 #include "fs/BufPageManager.hpp"
 
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <sys/mman.h>
+
+#include "common/Color.hpp"
+
 namespace dbs {
 namespace fs {
 
-BufPageManager::BufPageManager(FileManager* fileMgr) {
+int BufferPoolOptions::resolveShards() const {
+    int wanted = shards > 0 ? shards : static_cast<int>(std::thread::hardware_concurrency());
+    int count = 1;
+    while (count * 2 <= wanted && count * 2 <= MAX_SHARDS &&
+           frameCount / (count * 2) >= MIN_SHARD_FRAMES) {
+        count *= 2;
+    }
+    return count;
+}
+
+BufPageManager::BufPageManager(FileManager* fileMgr, const BufferPoolOptions& options) {
     fileManager = fileMgr;
-    pageReplacementStrategy = new FindReplace(CACHE_CAPACITY);
-    dirtyPageTracker = new utils::BitMap(CACHE_CAPACITY, false);
-    pageBuffers = new BufType[CACHE_CAPACITY];
-    for (int i = 0; i < CACHE_CAPACITY; ++i) {
-        pageBuffers[i] = nullptr;
+    frameCount = options.frameCount;
+    shardCount = options.resolveShards();
+    framesPerShard = (frameCount + shardCount - 1) / shardCount;
+    dirty = new uint8_t[frameCount]();
+    loading = new uint8_t[frameCount]();
+    pinCount = new int[frameCount]();
+    pageLocations = new PageLocation[frameCount];
+    handedOut = new std::atomic<uint64_t>[frameCount];
+    frameHits = new std::atomic<uint64_t>[frameCount];
+    unlogged = new uint8_t[frameCount]();
+    pageLSN = new uint64_t[frameCount]();
+    for (int i = 0; i < frameCount; ++i) {
+        handedOut[i].store(0, std::memory_order_relaxed);
+        frameHits[i].store(0, std::memory_order_relaxed);
+    }
+
+    shards = new Shard[shardCount];
+    for (int i = 0; i < shardCount; ++i) {
+        Shard& shard = shards[i];
+        shard.firstFrame = i * framesPerShard;
+        shard.frames = std::min(framesPerShard, frameCount - shard.firstFrame);
+        shard.pageTable = new PageTable(shard.frames);
+        shard.policy = FindReplace::create(options.policy, shard.frames);
+        shard.dirtyHighWater = static_cast<int>(static_cast<long long>(shard.frames) *
+                                                options.dirtyThresholdPercent / 100);
+        shard.dirtyLowWater = shard.dirtyHighWater * 3 / 4;
+        shard.accessRing = new std::atomic<int>[ACCESS_RING];
+        for (int j = 0; j < ACCESS_RING; ++j) {
+            shard.accessRing[j].store(-1, std::memory_order_relaxed);
+        }
+    }
+
+    allocateArena(options.hugePages);
+    wal = nullptr;
+    lostWrites = false;
+    checkpointBytes = static_cast<uint64_t>(options.checkpointMegabytes) << 20;
+    readAhead = nullptr;
+    if (options.readAheadPages > 0) {
+        readAhead = new ReadAhead(fileMgr, options.readAheadPages, options.ioUring);
+        readAhead->setResidencyCheck([this](int fileID, int pageID) {
+            // Runs under the read-ahead lock, which is also taken by threads
+            // holding a shard latch, so never block on the latch here.
+            Shard& shard = shardOf(fileID, pageID);
+            std::shared_lock<std::shared_mutex> lock(shard.latch, std::try_to_lock);
+            return lock.owns_lock() && shard.pageTable->find(fileID, pageID) != -1;
+        });
+    }
+
+    writerIntervalMs = options.writerIntervalMs > 0 ? options.writerIntervalMs : 1;
+    writerStopping = false;
+    if (options.dirtyThresholdPercent > 0) {
+        writer = std::thread(&BufPageManager::writerLoop, this);
     }
-    pageHashMap = new utils::HashMap<utils::HashItemTwoInt>();
-    pageLocations = new PageLocation[CACHE_CAPACITY];
-    lastAccessedPageIndex = -1;
+
+    syncIntervalMs = options.syncIntervalMs > 0 ? options.syncIntervalMs : 1;
+    durability = Durability::STRICT;
+    setDurability(options.durability);
 }
 
 BufPageManager::~BufPageManager() {
+    {
+        std::lock_guard<std::mutex> guard(writerMutex);
+        writerStopping = true;
+    }
+    writerWakeup.notify_one();
+    syncerWakeup.notify_one();
+    if (writer.joinable()) {
+        writer.join();
+    }
+    if (syncer.joinable()) {
+        syncer.join();
+    }
+    delete readAhead;
     fileManager = nullptr;
-    delete pageReplacementStrategy;
-    delete dirtyPageTracker;
-    delete[] pageBuffers;
-    delete pageHashMap;
+    for (int i = 0; i < shardCount; ++i) {
+        delete shards[i].pageTable;
+        delete shards[i].policy;
+        delete[] shards[i].accessRing;
+    }
+    delete[] shards;
+    delete[] dirty;
+    delete[] loading;
+    delete[] pinCount;
     delete[] pageLocations;
+    delete[] handedOut;
+    delete[] frameHits;
+    delete[] unlogged;
+    delete[] pageLSN;
+    if (arenaMapped) {
+        munmap(arena, arenaBytes);
+    } else {
+        std::free(arena);
+    }
 }
 
-BufType BufPageManager::allocateMemory() {
-    return new unsigned int[(PAGE_SIZE_BY_BYTE >> 2)];
+void BufPageManager::allocateArena(bool hugePages) {
+    arenaBytes = static_cast<size_t>(frameCount) * PAGE_SIZE_BY_BYTE;
+    if (hugePages) {
+        // Round up so the whole arena can be backed by 2MB pages.
+        const size_t hugePageBytes = 2UL << 20;
+        arenaBytes = (arenaBytes + hugePageBytes - 1) / hugePageBytes * hugePageBytes;
+    }
+    // Anonymous mappings are page-aligned and only committed on first touch,
+    // so an oversized pool costs nothing until it is actually filled.
+    void* memory = mmap(nullptr, arenaBytes, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory != MAP_FAILED) {
+        arenaMapped = true;
+#ifdef MADV_HUGEPAGE
+        if (hugePages && madvise(memory, arenaBytes, MADV_HUGEPAGE) != 0) {
+            std::cerr << Color::WARNING << "Transparent huge pages unavailable for the buffer pool"
+                      << Color::ENDC << std::endl;
+        }
+#endif
+    } else {
+        arenaMapped = false;
+        memory = std::aligned_alloc(PAGE_SIZE_BY_BYTE, arenaBytes);
+        if (memory == nullptr) {
+            std::cerr << Color::FAIL << "DB failed to allocate the buffer pool (" << arenaBytes
+                      << " bytes)" << Color::ENDC << std::endl;
+            std::abort();
+        }
+    }
+    arena = static_cast<BufType>(memory);
+    // Frames are whole pages in a page-aligned arena, so they satisfy O_DIRECT.
+    static_assert(PAGE_SIZE_BY_BYTE % DIRECT_IO_ALIGNMENT == 0, "frames must stay O_DIRECT-aligned");
+    assert(reinterpret_cast<uintptr_t>(arena) % DIRECT_IO_ALIGNMENT == 0);
 }
 
-BufType BufPageManager::loadPage(int fileID, int pageID, int& pageIndex) {
-    BufType buffer;
-    pageIndex = pageReplacementStrategy->find();
-    buffer = pageBuffers[pageIndex];
-
-    if (buffer == nullptr) {
-        buffer = allocateMemory();
-        pageBuffers[pageIndex] = buffer;
-    } else {
-        if (dirtyPageTracker->getBit(pageIndex)) {
-            fileManager->writePage(pageLocations[pageIndex].fileID,
-                                   pageLocations[pageIndex].pageID, buffer, 0);
-            dirtyPageTracker->setBit(pageIndex, false);
+int BufPageManager::loadPage(Shard& shard, int fileID, int pageID) {
+    drainAccesses(shard);
+    // Victims whose write-back failed keep their page; they are pinned
+    // while another victim is chosen.
+    std::vector<int> unwritable;
+    int pageIndex;
+    while (true) {
+        int local = shard.policy->find();
+        if (local == -1) {
+            std::cerr << Color::FAIL << "DB buffer pool exhausted: all " << shard.frames
+                      << " frames of a shard are pinned or cannot be written back"
+                      << Color::ENDC << std::endl;
+            std::abort();
         }
-        assert(pageHashMap->deleteItem(pageLocations[pageIndex].toHashItem()));
+        pageIndex = shard.firstFrame + local;
+        if (pageLocations[pageIndex].fileID == -1 || !dirty[pageIndex] ||
+            writeFrame(shard, pageIndex)) {
+            break;
+        }
+        pinFrame(shard, pageIndex);
+        unwritable.push_back(pageIndex);
+    }
+    for (int frame : unwritable) {
+        unpinFrame(shard, frame);
     }
 
-    pageHashMap->insertItem(utils::HashItemTwoInt(fileID, pageID, pageIndex));
+    if (pageLocations[pageIndex].fileID != -1) {
+        foldHits(shard, pageIndex);
+        statsFor(shard, pageLocations[pageIndex].fileID).evictions++;
+        bool erased = shard.pageTable->erase(pageLocations[pageIndex].fileID,
+                                             pageLocations[pageIndex].pageID);
+        assert(erased);
+        (void)erased;
+    }
+
+    shard.pageTable->insert(fileID, pageID, pageIndex);
     pageLocations[pageIndex] = PageLocation(fileID, pageID);
-    return buffer;
+    BufferStats& stats = statsFor(shard, fileID);
+    stats.misses++;
+    stats.readBytes += PAGE_SIZE_BY_BYTE;
+    // Keep the frame out of reach of eviction and of other readers until
+    // the caller has read the page in.
+    loading[pageIndex] = 1;
+    pinFrame(shard, pageIndex);
+    // find() already counted the load as a reference; do not count the
+    // caller's follow-up access again (it would promote scan pages in 2Q/LRU-K).
+    shard.lastAccessed.store(pageIndex, std::memory_order_relaxed);
+    return pageIndex;
+}
+
+void BufPageManager::recordAccess(Shard& shard, int pageIndex) {
+    if (shard.lastAccessed.load(std::memory_order_relaxed) == pageIndex) {
+        return;
+    }
+    shard.lastAccessed.store(pageIndex, std::memory_order_relaxed);
+    uint64_t tick = shard.accessTick.fetch_add(1, std::memory_order_relaxed);
+    shard.accessRing[tick & (ACCESS_RING - 1)].store(pageIndex, std::memory_order_release);
+}
+
+void BufPageManager::drainAccesses(Shard& shard) {
+    uint64_t end = shard.accessTick.load(std::memory_order_acquire);
+    uint64_t begin = shard.drainedTick;
+    if (end - begin > ACCESS_RING) {
+        begin = end - ACCESS_RING;  // the ring is lossy: older hits were overwritten
+    }
+    for (uint64_t tick = begin; tick < end; ++tick) {
+        int pageIndex = shard.accessRing[tick & (ACCESS_RING - 1)].exchange(
+            -1, std::memory_order_acquire);
+        if (pageIndex != -1 && pageLocations[pageIndex].fileID != -1) {
+            shard.policy->access(pageIndex - shard.firstFrame);
+        }
+    }
+    shard.drainedTick = end;
+}
+
+void BufPageManager::pinFrame(Shard& shard, int pageIndex) {
+    if (pinCount[pageIndex]++ == 0) {
+        shard.policy->pin(pageIndex - shard.firstFrame);
+    }
+}
+
+void BufPageManager::unpinFrame(Shard& shard, int pageIndex) {
+    assert(pinCount[pageIndex] > 0);
+    if (--pinCount[pageIndex] == 0) {
+        shard.policy->unpin(pageIndex - shard.firstFrame);
+    }
 }
 
 void BufPageManager::accessPage(int pageIndex) {
-    if (pageIndex != lastAccessedPageIndex) {
-        pageReplacementStrategy->access(pageIndex);
-        lastAccessedPageIndex = pageIndex;
+    if (pageIndex != -1) {
+        recordAccess(shardOfFrame(pageIndex), pageIndex);
     }
 }
 
-BufType BufPageManager::getPage(int fileID, int pageID, int& pageIndex) {
-    utils::HashItemTwoInt searchItem(fileID, pageID);
-    searchItem = pageHashMap->findItem(searchItem);
-    pageIndex = searchItem.value;
+BufType BufPageManager::lookup(Shard& shard, int fileID, int pageID, int& pageIndex) {
+    std::shared_lock<std::shared_mutex> lock(shard.latch);
+    while (true) {
+        pageIndex = shard.pageTable->find(fileID, pageID);
+        if (pageIndex == -1) {
+            return nullptr;
+        }
+        if (!loading[pageIndex]) {
+            break;
+        }
+        shard.loaded.wait(lock);
+    }
+    frameHits[pageIndex].fetch_add(1, std::memory_order_relaxed);
+    recordAccess(shard, pageIndex);
+    handOut(pageIndex);
+    return frameBuffer(pageIndex);
+}
 
+BufType BufPageManager::fetch(Shard& shard, int fileID, int pageID, int& pageIndex, bool pin) {
+    std::unique_lock<std::shared_mutex> lock(shard.latch);
+    while (true) {
+        pageIndex = shard.pageTable->find(fileID, pageID);
+        if (pageIndex == -1 || !loading[pageIndex]) {
+            break;
+        }
+        shard.loaded.wait(lock);
+    }
     if (pageIndex != -1) {
-        accessPage(pageIndex);
-        return pageBuffers[pageIndex];
-    } else {
-        BufType buffer = loadPage(fileID, pageID, pageIndex);
+        frameHits[pageIndex].fetch_add(1, std::memory_order_relaxed);
+        recordAccess(shard, pageIndex);
+        if (pin) {
+            pinFrame(shard, pageIndex);
+        } else {
+            handOut(pageIndex);
+        }
+        return frameBuffer(pageIndex);
+    }
+
+    pageIndex = loadPage(shard, fileID, pageID);
+    BufType buffer = frameBuffer(pageIndex);
+    lock.unlock();
+    if (readAhead == nullptr || !readAhead->take(fileID, pageID, buffer)) {
         fileManager->readPage(fileID, pageID, buffer, 0);
+    }
+    lock.lock();
+    loading[pageIndex] = 0;
+    if (!pin) {
+        unpinFrame(shard, pageIndex);
+        handOut(pageIndex);
+    }
+    shard.loaded.notify_all();
+    return buffer;
+}
+
+BufType BufPageManager::getPage(int fileID, int pageID, int& pageIndex) {
+    Shard& shard = shardOf(fileID, pageID);
+    BufType buffer = lookup(shard, fileID, pageID, pageIndex);
+    return buffer != nullptr ? buffer : fetch(shard, fileID, pageID, pageIndex, false);
+}
+
+BufType BufPageManager::getPageReadOnly(int fileID, int pageID, int& pageIndex) {
+    Shard& shard = shardOf(fileID, pageID);
+    BufType buffer = lookup(shard, fileID, pageID, pageIndex);
+    if (buffer != nullptr) {
         return buffer;
     }
+    // Not resident, so the file holds the newest version of the page.
+    BufType mapped = fileManager->mapPage(fileID, pageID);
+    if (mapped != nullptr) {
+        shard.mappedReads.fetch_add(1, std::memory_order_relaxed);
+        pageIndex = -1;
+        return mapped;
+    }
+    return fetch(shard, fileID, pageID, pageIndex, false);
 }
 
 void BufPageManager::markPageDirty(int pageIndex) {
-    dirtyPageTracker->setBit(pageIndex, true);
-    accessPage(pageIndex);
+    assert(pageIndex != -1);  // mapped read-only pages cannot be modified
+    Shard& shard = shardOfFrame(pageIndex);
+    std::unique_lock<std::shared_mutex> lock(shard.latch);
+    setDirty(shard, pageIndex, true);
+    recordAccess(shard, pageIndex);
+    handOut(pageIndex);
+}
+
+BufType BufPageManager::pinPage(int fileID, int pageID, int& pageIndex) {
+    return fetch(shardOf(fileID, pageID), fileID, pageID, pageIndex, true);
 }
 
-void BufPageManager::flushPageToDisk(int pageIndex) {
-    if (dirtyPageTracker->getBit(pageIndex)) {
-        fileManager->writePage(pageLocations[pageIndex].fileID,
-                               pageLocations[pageIndex].pageID, pageBuffers[pageIndex], 0);
-        dirtyPageTracker->setBit(pageIndex, false);
+void BufPageManager::unpinPage(int pageIndex, bool dirty_) {
+    Shard& shard = shardOfFrame(pageIndex);
+    std::unique_lock<std::shared_mutex> lock(shard.latch);
+    if (dirty_) {
+        setDirty(shard, pageIndex, true);
     }
+    unpinFrame(shard, pageIndex);
 }
 
-void BufPageManager::releasePage(int pageIndex) {
-    flushPageToDisk(pageIndex);
-    pageReplacementStrategy->free(pageIndex);
-    pageHashMap->deleteItem(pageLocations[pageIndex].toHashItem());
+void BufPageManager::setDirty(Shard& shard, int pageIndex, bool dirty_) {
+    if (dirty_ && wal != nullptr && !unlogged[pageIndex]) {
+        // Also when the frame is already dirty: its logged image is stale now.
+        unlogged[pageIndex] = 1;
+        shard.unloggedFrames.push_back(pageIndex);
+    }
+    if (dirty[pageIndex] == static_cast<uint8_t>(dirty_)) {
+        return;
+    }
+    dirty[pageIndex] = dirty_;
+    if (dirty_) {
+        // Wake the writer once, when the shard crosses its threshold.
+        if (++shard.dirtyCount == shard.dirtyHighWater + 1 && writer.joinable()) {
+            writerWakeup.notify_one();
+        }
+    } else {
+        --shard.dirtyCount;
+        unlogged[pageIndex] = 0;
+    }
+}
+
+uint64_t BufPageManager::logFrame(int pageIndex) {
+    if (wal == nullptr) {
+        return 0;
+    }
+    if (unlogged[pageIndex]) {
+        std::string path = fileManager->getFileName(pageLocations[pageIndex].fileID);
+        if (path.empty()) {
+            return 0;  // the file was closed under the page; nothing to recover
+        }
+        pageLSN[pageIndex] = wal->appendPage(path, pageLocations[pageIndex].pageID,
+                                             frameBuffer(pageIndex));
+        unlogged[pageIndex] = 0;
+    }
+    return pageLSN[pageIndex];
+}
+
+bool BufPageManager::writeFrame(Shard& shard, int pageIndex) {
+    const PageLocation& location = pageLocations[pageIndex];
+    if (readAhead != nullptr) {
+        readAhead->invalidate(location.fileID, location.pageID);
+    }
+    // Write-ahead rule: the page image reaches the log before the file.
+    uint64_t lsn = logFrame(pageIndex);
+    if (lsn != 0 && !wal->flush(lsn, syncLog())) {
+        return false;
+    }
+    if (!fileManager->writePage(location.fileID, location.pageID, frameBuffer(pageIndex), 0)) {
+        reportWriteFailure(location.fileID, location.pageID);
+        return false;
+    }
+    BufferStats& stats = statsFor(shard, location.fileID);
+    stats.dirtyWrites++;
+    stats.writeBytes += PAGE_SIZE_BY_BYTE;
+    setDirty(shard, pageIndex, false);
+    return true;
+}
+
+void BufPageManager::reportWriteFailure(int fileID, int pageID) {
+    std::cerr << Color::FAIL << "DB failed to write page " << pageID << " of "
+              << fileManager->getFileName(fileID) << ": " << std::strerror(errno)
+              << Color::ENDC << std::endl;
+}
+
+void BufPageManager::beginScan(int fileID, int firstPageID, int endPageID) {
+    if (fileManager->mmapReadsEnabled()) {
+        // Scans read through the mapping; let the kernel do the read-ahead.
+        fileManager->mapPage(fileID, firstPageID);
+        fileManager->adviseSequential(fileID, firstPageID, endPageID);
+        return;
+    }
+    if (readAhead != nullptr && endPageID - firstPageID > 1) {
+        readAhead->beginScan(fileID, firstPageID, endPageID);
+    }
+}
+
+void BufPageManager::endScan(int fileID) {
+    if (readAhead != nullptr) {
+        readAhead->endScan(fileID);
+    }
+}
+
+void BufPageManager::releasePage(Shard& shard, int pageIndex) {
+    assert(pinCount[pageIndex] == 0);
+    if (dirty[pageIndex] && !writeFrame(shard, pageIndex)) {
+        // The file is about to be closed, so the page cannot stay cached.
+        // Its logged image (if any) is now the only copy of the changes.
+        lostWrites = true;
+        setDirty(shard, pageIndex, false);
+    }
+    foldHits(shard, pageIndex);
+    shard.policy->free(pageIndex - shard.firstFrame);
+    shard.pageTable->erase(pageLocations[pageIndex].fileID, pageLocations[pageIndex].pageID);
+    pageLocations[pageIndex] = PageLocation();
+}
+
+bool BufPageManager::flushAll() {
+    std::vector<std::unique_lock<std::shared_mutex>> locks;
+    locks.reserve(shardCount);
+    for (int i = 0; i < shardCount; ++i) {
+        locks.emplace_back(shards[i].latch);
+    }
+    return flushAllLocked();
+}
+
+bool BufPageManager::flushAllLocked(int fileID) {
+    std::vector<int> dirtyFrames;
+    for (int i = 0; i < frameCount; ++i) {
+        if (pageLocations[i].fileID != -1 && dirty[i] && !loading[i] &&
+            (fileID == -1 || pageLocations[i].fileID == fileID)) {
+            dirtyFrames.push_back(i);
+        }
+    }
+    uint64_t lsn = 0;
+    for (int pageIndex : dirtyFrames) {
+        lsn = std::max(lsn, logFrame(pageIndex));
+    }
+    if (lsn != 0 && !wal->flush(lsn, syncLog())) {
+        return false;  // the log does not cover the pages; none may be written
+    }
+    std::sort(dirtyFrames.begin(), dirtyFrames.end(), [this](int a, int b) {
+        const PageLocation& la = pageLocations[a];
+        const PageLocation& lb = pageLocations[b];
+        return la.fileID != lb.fileID ? la.fileID < lb.fileID : la.pageID < lb.pageID;
+    });
+
+    bool ok = true;
+    std::vector<BufType> run;
+    size_t start = 0;
+    while (start < dirtyFrames.size()) {
+        const PageLocation& first = pageLocations[dirtyFrames[start]];
+        size_t end = start;
+        run.clear();
+        while (end < dirtyFrames.size() &&
+               pageLocations[dirtyFrames[end]].fileID == first.fileID &&
+               pageLocations[dirtyFrames[end]].pageID == first.pageID + static_cast<int>(end - start)) {
+            run.push_back(frameBuffer(dirtyFrames[end]));
+            if (readAhead != nullptr) {
+                readAhead->invalidate(first.fileID, pageLocations[dirtyFrames[end]].pageID);
+            }
+            ++end;
+        }
+        if (!fileManager->writePages(first.fileID, first.pageID, run.data(),
+                                     static_cast<int>(run.size()))) {
+            // Some pages of the run may have reached the file, but none is
+            // known to; all of them stay dirty.
+            reportWriteFailure(first.fileID, first.pageID);
+            ok = false;
+            start = end;
+            continue;
+        }
+        for (size_t i = start; i < end; ++i) {
+            Shard& shard = shardOfFrame(dirtyFrames[i]);
+            BufferStats& stats = statsFor(shard, first.fileID);
+            stats.dirtyWrites++;
+            stats.writeBytes += PAGE_SIZE_BY_BYTE;
+            setDirty(shard, dirtyFrames[i], false);
+        }
+        start = end;
+    }
+    return ok;
 }
 
 void BufPageManager::closeManager() {
-    for (int i = 0; i < CACHE_CAPACITY; ++i) {
-        if (pageBuffers[i] != nullptr) {
-            releasePage(i);
-            delete[] pageBuffers[i];
-            pageBuffers[i] = nullptr;
+    std::vector<std::unique_lock<std::shared_mutex>> locks;
+    locks.reserve(shardCount);
+    for (int i = 0; i < shardCount; ++i) {
+        locks.emplace_back(shards[i].latch);
+    }
+    if (readAhead != nullptr) {
+        readAhead->clear();
+    }
+    flushAllLocked();
+    for (int i = 0; i < shardCount; ++i) {
+        drainAccesses(shards[i]);
+    }
+    for (int i = 0; i < frameCount; ++i) {
+        if (pageLocations[i].fileID != -1) {
+            releasePage(shardOfFrame(i), i);
+        }
+    }
+}
+
+void BufPageManager::releaseFile(int fileID) {
+    std::vector<std::unique_lock<std::shared_mutex>> locks;
+    locks.reserve(shardCount);
+    for (int i = 0; i < shardCount; ++i) {
+        locks.emplace_back(shards[i].latch);
+    }
+    if (readAhead != nullptr) {
+        readAhead->endScan(fileID);
+    }
+    flushAllLocked(fileID);
+    for (int i = 0; i < shardCount; ++i) {
+        drainAccesses(shards[i]);
+    }
+    for (int i = 0; i < frameCount; ++i) {
+        if (pageLocations[i].fileID == fileID) {
+            releasePage(shardOfFrame(i), i);
+        }
+    }
+}
+
+bool BufPageManager::commit() {
+    // Buffers handed out by getPage are not used past the statement.
+    statementEpoch.fetch_add(1, std::memory_order_relaxed);
+    if (wal == nullptr) {
+        Durability mode = getDurability();
+        if (mode == Durability::PERIODIC) {
+            // Pages are only consistent between statements, so the data files
+            // are synced here rather than by the syncer thread.
+            auto now = std::chrono::steady_clock::now();
+            if (now - lastDataSync < std::chrono::milliseconds(syncIntervalMs)) {
+                return true;
+            }
+            lastDataSync = now;
+        }
+        if (mode != Durability::OFF) {
+            if (!flushAll()) {
+                return false;
+            }
+            fileManager->syncAll();
+        }
+        return true;
+    }
+    for (int i = 0; i < shardCount; ++i) {
+        Shard& shard = shards[i];
+        std::unique_lock<std::shared_mutex> lock(shard.latch);
+        for (int pageIndex : shard.unloggedFrames) {
+            if (unlogged[pageIndex] && pageLocations[pageIndex].fileID != -1) {
+                logFrame(pageIndex);
+            }
+        }
+        shard.unloggedFrames.clear();
+    }
+    // Also covers file deletions logged by the FileManager.
+    if (!wal->flush(wal->lastLSN(), syncLog())) {
+        return false;
+    }
+    if (wal->sizeBytes() > checkpointBytes) {
+        checkpoint();
+    }
+    return true;
+}
+
+void BufPageManager::checkpoint() {
+    if (wal == nullptr) {
+        return;
+    }
+    std::vector<std::unique_lock<std::shared_mutex>> locks;
+    locks.reserve(shardCount);
+    for (int i = 0; i < shardCount; ++i) {
+        locks.emplace_back(shards[i].latch);
+    }
+    if (!flushAllLocked() || lostWrites) {
+        // Some page never reached its file; the log still holds its image.
+        std::cerr << Color::WARNING << "Checkpoint skipped: dirty pages could not be written back"
+                  << Color::ENDC << std::endl;
+        return;
+    }
+    if (getDurability() != Durability::OFF) {
+        wal->syncDataFiles();
+    }
+    wal->truncate();
+    for (int i = 0; i < shardCount; ++i) {
+        shards[i].unloggedFrames.clear();
+    }
+}
+
+void BufPageManager::setLog(WriteAheadLog* log_) {
+    std::lock_guard<std::mutex> guard(writerMutex);
+    wal = log_;
+}
+
+void BufPageManager::setDurability(Durability mode) {
+    durability = mode;
+    std::lock_guard<std::mutex> guard(writerMutex);
+    if (mode == Durability::PERIODIC && !syncer.joinable() && !writerStopping) {
+        syncer = std::thread(&BufPageManager::syncerLoop, this);
+    }
+}
+
+bool BufPageManager::parseDurability(const std::string& name, Durability& mode) {
+    std::string lower = name;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    if (lower == "off") {
+        mode = Durability::OFF;
+    } else if (lower == "periodic") {
+        mode = Durability::PERIODIC;
+    } else if (lower == "strict") {
+        mode = Durability::STRICT;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* BufPageManager::durabilityName(Durability mode) {
+    switch (mode) {
+        case Durability::OFF:
+            return "off";
+        case Durability::PERIODIC:
+            return "periodic";
+        case Durability::STRICT:
+        default:
+            return "strict";
+    }
+}
+
+void BufPageManager::syncerLoop() {
+    std::unique_lock<std::mutex> lock(writerMutex);
+    while (!writerStopping) {
+        syncerWakeup.wait_for(lock, std::chrono::milliseconds(syncIntervalMs));
+        if (writerStopping || getDurability() != Durability::PERIODIC) {
+            continue;
+        }
+        // Keeps writerMutex so that setLog cannot swap the log underneath.
+        // Without a log, commit syncs the data files itself.
+        if (wal != nullptr) {
+            // Statements already wrote their records out; make them durable.
+            wal->flush(wal->lastLSN(), true);
+        }
+    }
+}
+
+void BufPageManager::writerLoop() {
+    std::vector<int> candidates;
+    std::unique_lock<std::mutex> lock(writerMutex);
+    while (!writerStopping) {
+        writerWakeup.wait_for(lock, std::chrono::milliseconds(writerIntervalMs));
+        if (writerStopping) {
+            break;
+        }
+        lock.unlock();
+        for (int i = 0; i < shardCount && !writerStopping; ++i) {
+            trickle(shards[i], candidates);
+        }
+        lock.lock();
+    }
+}
+
+void BufPageManager::trickle(Shard& shard, std::vector<int>& candidates) {
+    std::unique_lock<std::shared_mutex> lock(shard.latch);
+    if (shard.dirtyCount <= shard.dirtyHighWater) {
+        return;
+    }
+    drainAccesses(shard);
+    candidates.resize(std::min(shard.frames, 1024));
+    int count = shard.policy->coldest(candidates.data(), static_cast<int>(candidates.size()));
+    for (int i = 0; i < count && shard.dirtyCount > shard.dirtyLowWater && !writerStopping; ++i) {
+        int pageIndex = shard.firstFrame + candidates[i];
+        // The latch was dropped since the list was taken; recheck the frame.
+        if (pageLocations[pageIndex].fileID == -1 || !dirty[pageIndex] || pinCount[pageIndex] > 0) {
+            continue;
+        }
+        // A caller may still be writing into a buffer that getPage handed
+        // out during the running statement; only pages released since
+        // (unpinned, or left by an earlier statement) are safe to copy.
+        if (handedOut[pageIndex].load(std::memory_order_relaxed) ==
+                statementEpoch.load(std::memory_order_relaxed)) {
+            continue;
+        }
+        if (!writeFrame(shard, pageIndex)) {
+            break;  // the frame stays dirty; try again on the next wake-up
+        }
+        shard.backgroundWrites++;
+        // Let a waiting foreground request in between two writes.
+        lock.unlock();
+        std::this_thread::yield();
+        lock.lock();
+    }
+}
+
+BufferStats& BufPageManager::statsFor(Shard& shard, int fileID) {
+    auto it = shard.fileStats.find(fileID);
+    if (it == shard.fileStats.end()) {
+        it = shard.fileStats.emplace(fileID, std::make_pair(fileManager->getFileName(fileID),
+                                                            BufferStats())).first;
+    }
+    return it->second.second;
+}
+
+void BufPageManager::foldHits(Shard& shard, int pageIndex) {
+    uint64_t hits = frameHits[pageIndex].exchange(0, std::memory_order_relaxed);
+    if (hits != 0) {
+        statsFor(shard, pageLocations[pageIndex].fileID).hits += hits;
+    }
+}
+
+void BufPageManager::getStats(BufferPoolStats& stats) {
+    stats = BufferPoolStats();
+    for (int i = 0; i < shardCount; ++i) {
+        Shard& shard = shards[i];
+        std::unique_lock<std::shared_mutex> lock(shard.latch);
+        for (int pageIndex = shard.firstFrame; pageIndex < shard.firstFrame + shard.frames; ++pageIndex) {
+            if (pageLocations[pageIndex].fileID != -1) {
+                foldHits(shard, pageIndex);
+            }
+        }
+        for (auto& entry : shard.fileStats) {
+            stats.files[entry.second.first].add(entry.second.second);
+            stats.total.add(entry.second.second);
+        }
+        stats.backgroundWrites += shard.backgroundWrites;
+        stats.mappedReads += shard.mappedReads.load(std::memory_order_relaxed);
+    }
+}
+
+void BufPageManager::resetStats() {
+    for (int i = 0; i < shardCount; ++i) {
+        Shard& shard = shards[i];
+        std::unique_lock<std::shared_mutex> lock(shard.latch);
+        for (int pageIndex = shard.firstFrame; pageIndex < shard.firstFrame + shard.frames; ++pageIndex) {
+            frameHits[pageIndex].store(0, std::memory_order_relaxed);
         }
+        shard.fileStats.clear();
+        shard.backgroundWrites = 0;
+        shard.mappedReads.store(0, std::memory_order_relaxed);
     }
 }
 
@@ -0,0 +1,85 @@
+#include "fs/FileHandleCache.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+namespace dbs {
+namespace fs {
+
+FileHandleCache::FileHandleCache(FileManager* fileMgr, BufPageManager* bufMgr, int capacity_) {
+    fm = fileMgr;
+    bpm = bufMgr;
+    capacity = std::max(capacity_, MIN_FILE_HANDLE_CACHE_CAPACITY);
+}
+
+FileHandleCache::~FileHandleCache() {
+    closeAll();
+    fm = nullptr;
+    bpm = nullptr;
+}
+
+int FileHandleCache::open(const char* filePath) {
+    std::lock_guard<std::mutex> guard(mutex);
+    auto it = byPath.find(filePath);
+    if (it != byPath.end()) {
+        entries.splice(entries.begin(), entries, it->second);
+        return it->second->fileID;
+    }
+    int fileID = fm->openFile(filePath);
+    if (fileID == -1) {
+        return -1;
+    }
+    while (static_cast<int>(entries.size()) >= capacity) {
+        closeEntry(std::prev(entries.end()));
+    }
+    entries.push_front(Entry{filePath, fileID});
+    byPath.emplace(entries.front().path, entries.begin());
+    return fileID;
+}
+
+int FileHandleCache::find(const char* filePath) {
+    std::lock_guard<std::mutex> guard(mutex);
+    auto it = byPath.find(filePath);
+    if (it == byPath.end()) {
+        return -1;
+    }
+    entries.splice(entries.begin(), entries, it->second);
+    return it->second->fileID;
+}
+
+void FileHandleCache::close(const char* filePath) {
+    std::lock_guard<std::mutex> guard(mutex);
+    auto it = byPath.find(filePath);
+    if (it != byPath.end()) {
+        closeEntry(it->second);
+    }
+}
+
+void FileHandleCache::closeAll() {
+    std::lock_guard<std::mutex> guard(mutex);
+    // One pass over the pool instead of one per file.
+    bpm->closeManager();
+    for (const Entry& entry : entries) {
+        fm->closeFile(entry.fileID);
+    }
+    entries.clear();
+    byPath.clear();
+}
+
+void FileHandleCache::setCapacity(int capacity_) {
+    std::lock_guard<std::mutex> guard(mutex);
+    capacity = std::max(capacity_, MIN_FILE_HANDLE_CACHE_CAPACITY);
+    while (static_cast<int>(entries.size()) > capacity) {
+        closeEntry(std::prev(entries.end()));
+    }
+}
+
+void FileHandleCache::closeEntry(std::list<Entry>::iterator entry) {
+    bpm->releaseFile(entry->fileID);
+    fm->closeFile(entry->fileID);
+    byPath.erase(entry->path);
+    entries.erase(entry);
+}
+
+}  // namespace fs
+}  // namespace dbs
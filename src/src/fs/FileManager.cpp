@@ -1,37 +1,137 @@
 #include "fs/FileManager.hpp"
 #include "common/Color.hpp"
+#include "fs/WriteAheadLog.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <sys/mman.h>
 
 namespace dbs {
 namespace fs {
 
 // Write data to a specific page in a file with an optional offset within the page
 bool FileManager::writePage(int fileID, int pageID, BufType buffer, int offset) {
-    int fileDesc = openFiles[fileID];  // Get the file descriptor from the open files map
+    int fileDesc = descriptorOf(fileID);  // Get the file descriptor from the open files map
     off_t fileOffset = static_cast<off_t>(pageID) << PAGE_SIZE_IDX;  // Calculate the byte offset for the page
-    off_t error = lseek(fileDesc, fileOffset, SEEK_SET);  // Seek to the correct position in the file
-    if (error != fileOffset) return false;  // If seeking fails, return false
 
     BufType dataBuffer = buffer + offset;  // Adjust the buffer by the offset
-    error = write(fileDesc, static_cast<void*>(dataBuffer), PAGE_SIZE_BY_BYTE);  // Write data to the file
-    return error != -1;  // Return true if write is successful, false otherwise
+    ssize_t error = pwrite(fileDesc, static_cast<void*>(dataBuffer), PAGE_SIZE_BY_BYTE, fileOffset);  // Positional write, no seek needed
+    return error == PAGE_SIZE_BY_BYTE;  // Return true if the whole page was written
+}
+
+// Write a run of consecutive pages with as few pwritev calls as possible
+bool FileManager::writePages(int fileID, int firstPageID, const BufType* buffers, int count) {
+    int fileDesc = descriptorOf(fileID);  // Get the file descriptor from the open files map
+    struct iovec vectors[IOV_MAX_PAGES];
+    int done = 0;
+    while (done < count) {
+        int batch = std::min(count - done, IOV_MAX_PAGES);
+        for (int i = 0; i < batch; i++) {
+            vectors[i].iov_base = static_cast<void*>(buffers[done + i]);
+            vectors[i].iov_len = PAGE_SIZE_BY_BYTE;
+        }
+        off_t fileOffset = static_cast<off_t>(firstPageID + done) << PAGE_SIZE_IDX;
+        ssize_t written = pwritev(fileDesc, vectors, batch, fileOffset);
+        if (written == -1) return false;
+        // A short write still leaves whole pages on disk; continue from the
+        // first page that was not completely written.
+        int fullPages = static_cast<int>(written >> PAGE_SIZE_IDX);
+        if (fullPages == 0) {
+            if (!writePage(fileID, firstPageID + done, buffers[done], 0)) return false;
+            fullPages = 1;
+        }
+        done += fullPages;
+    }
+    return true;
 }
 
 // Read data from a specific page in a file with an optional offset within the page
 bool FileManager::readPage(int fileID, int pageID, BufType buffer, int offset) {
-    int fileDesc = openFiles[fileID];  // Get the file descriptor from the open files map
+    int fileDesc = descriptorOf(fileID);  // Get the file descriptor from the open files map
     off_t fileOffset = static_cast<off_t>(pageID) << PAGE_SIZE_IDX;  // Calculate the byte offset for the page
-    off_t error = lseek(fileDesc, fileOffset, SEEK_SET);  // Seek to the correct position in the file
-    if (error != fileOffset) return false;  // If seeking fails, return false
 
     BufType dataBuffer = buffer + offset;  // Adjust the buffer by the offset
-    error = read(fileDesc, static_cast<void*>(dataBuffer), PAGE_SIZE_BY_BYTE);  // Read data from the file
+    ssize_t error = pread(fileDesc, static_cast<void*>(dataBuffer), PAGE_SIZE_BY_BYTE, fileOffset);  // Positional read, no seek needed
     return error != -1;  // Return true if read is successful, false otherwise
 }
 
+// Look up the descriptor of an open file without inserting into the map
+int FileManager::getFileDescriptor(int fileID) const {
+    return descriptorOf(fileID);
+}
+
+// Look up the path an open file was opened with
+std::string FileManager::getFileName(int fileID) const {
+    std::shared_lock<std::shared_mutex> guard(latch);
+    auto it = fileNames.find(fileID);
+    return it == fileNames.end() ? std::string() : it->second;
+}
+
+// Descriptor lookup under the shared latch; the I/O itself runs unlatched
+int FileManager::descriptorOf(int fileID) const {
+    std::shared_lock<std::shared_mutex> guard(latch);
+    auto it = openFiles.find(fileID);
+    return it == openFiles.end() ? -1 : it->second;
+}
+
+// Map (or remap after growth) a file read-only and return a page inside it
+BufType FileManager::mapPage(int fileID, int pageID) {
+    if (!mmapReads) return nullptr;
+    size_t pageEnd = (static_cast<size_t>(pageID) + 1) << PAGE_SIZE_IDX;
+    {
+        std::shared_lock<std::shared_mutex> guard(latch);
+        auto it = mappings.find(fileID);
+        if (it != mappings.end() && pageEnd <= it->second.length) {
+            return reinterpret_cast<BufType>(it->second.base + (static_cast<size_t>(pageID) << PAGE_SIZE_IDX));
+        }
+    }
+    std::unique_lock<std::shared_mutex> guard(latch);
+    FileMapping& mapping = mappings[fileID];
+    if (pageEnd > mapping.length) {  // Re-check: another thread may have remapped meanwhile
+        auto fd = openFiles.find(fileID);
+        int fileDesc = fd == openFiles.end() ? -1 : fd->second;
+        struct stat fileInfo;
+        if (fileDesc == -1 || fstat(fileDesc, &fileInfo) != 0) return nullptr;
+        size_t fileLength = static_cast<size_t>(fileInfo.st_size) >> PAGE_SIZE_IDX << PAGE_SIZE_IDX;
+        if (pageEnd > fileLength) return nullptr;  // page only exists in the buffer pool
+        void* base = mmap(nullptr, fileLength, PROT_READ, MAP_SHARED, fileDesc, 0);
+        if (base == MAP_FAILED) return nullptr;
+        if (mapping.base != nullptr) {
+            mapping.retired.emplace_back(mapping.base, mapping.length);
+        }
+        mapping.base = static_cast<char*>(base);
+        mapping.length = fileLength;
+    }
+    return reinterpret_cast<BufType>(mapping.base + (static_cast<size_t>(pageID) << PAGE_SIZE_IDX));
+}
+
+// Hint sequential access over a range of an existing mapping
+void FileManager::adviseSequential(int fileID, int firstPageID, int endPageID) {
+    std::shared_lock<std::shared_mutex> guard(latch);
+    auto it = mappings.find(fileID);
+    if (it == mappings.end() || it->second.base == nullptr) return;
+    size_t begin = static_cast<size_t>(firstPageID) << PAGE_SIZE_IDX;
+    size_t end = std::min(static_cast<size_t>(endPageID) << PAGE_SIZE_IDX, it->second.length);
+    if (begin >= end) return;
+    madvise(it->second.base + begin, end - begin, MADV_WILLNEED);
+}
+
+// Drop every read-only view of a file
+void FileManager::unmapFile(int fileID) {
+    auto it = mappings.find(fileID);
+    if (it == mappings.end()) return;
+    if (it->second.base != nullptr) munmap(it->second.base, it->second.length);
+    for (auto& retired : it->second.retired) munmap(retired.first, retired.second);
+    mappings.erase(it);
+}
+
 // Close the file given its ID and remove it from the open files map
 void FileManager::closeFile(int fileID) {
+    std::unique_lock<std::shared_mutex> guard(latch);
+    unmapFile(fileID);  // Mapped pages of this file must not be used any more
     close(openFiles[fileID]);  // Close the file using its descriptor
     openFiles.erase(fileID);  // Remove the file from the open files map
+    fileNames.erase(fileID);
 }
 
 // Create a new file with the specified file name
@@ -47,13 +147,24 @@ bool FileManager::createFile(const char* fileName) {
 
 // Open an existing file by its name and return its file ID
 int FileManager::openFile(const char* fileName) {
-    int fileID = nextFileID++;  // Assign the next available file ID
-    int fileDesc = open(fileName, O_RDWR);  // Open the file with read/write permissions
+    int fileDesc = open(fileName, O_RDWR | (directIO ? O_DIRECT : 0));  // Open the file with read/write permissions
+    if (fileDesc == -1 && directIO && errno == EINVAL) {  // The file system does not support O_DIRECT
+        fileDesc = open(fileName, O_RDWR);
+        std::unique_lock<std::shared_mutex> guard(latch);
+        if (fileDesc != -1 && !directIOWarned) {
+            directIOWarned = true;
+            std::cerr << Color::WARNING << "O_DIRECT unsupported for " << fileName
+                      << ", using buffered I/O" << Color::ENDC << std::endl;
+        }
+    }
     if (fileDesc == -1) {  // If file opening fails
         std::cerr << Color::FAIL << "DB failed to open file: " << fileName << Color::ENDC << std::endl;  // Print error message
         return -1;  // Return -1 to indicate failure
     }
+    std::unique_lock<std::shared_mutex> guard(latch);
+    int fileID = nextFileID++;  // Assign the next available file ID
     openFiles[fileID] = fileDesc;  // Store the file descriptor in the open files map
+    fileNames[fileID] = fileName;
     return fileID;  // Return the file ID
 }
 
@@ -65,8 +176,25 @@ bool FileManager::doesFileExist(const char* fileName) {
     return true;  // Return true if file exists
 }
 
+// Flush every open file to disk; the descriptors are copied so that no latch is held across I/O
+void FileManager::syncAll() {
+    std::vector<int> descriptors;
+    {
+        std::shared_lock<std::shared_mutex> guard(latch);
+        for (const auto& entry : openFiles) {
+            descriptors.push_back(entry.second);
+        }
+    }
+    for (int fileDesc : descriptors) {
+        fdatasync(fileDesc);
+    }
+}
+
 // Delete a file given its name
 bool FileManager::deleteFile(const char* fileName) {
+    if (wal != nullptr && !wal->flush(wal->appendDelete(fileName), true)) {  // Redo the removal after a crash
+        return false;  // Not logged, so not done
+    }
     if (remove(fileName) != 0) {  // Try to remove the file
         std::cerr << Color::FAIL << "DB failed to delete file: " << fileName << Color::ENDC << std::endl;  // Print error message if deletion fails
         return false;  // Return false
@@ -91,6 +219,9 @@ bool FileManager::createFolder(const char* folderPath) {
 
 // Delete a folder and its contents recursively by its path
 bool FileManager::deleteFolder(const char* folderPath) {
+    if (wal != nullptr && !wal->flush(wal->appendDelete(folderPath), true)) {  // Redo the removal after a crash
+        return false;  // Not logged, so not done
+    }
     DIR* dir = opendir(folderPath);  // Open the directory for reading
     struct dirent* entry;  // Directory entry structure to hold each file/directory name
 
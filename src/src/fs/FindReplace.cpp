@@ -3,66 +3,410 @@
 namespace dbs {
 namespace fs {
 
+FindReplace::FindReplace(int capacity_) {
+    capacity = capacity_;
+    pinned = new uint8_t[capacity]();
+    pinnedCount = 0;
+}
+
+FindReplace::~FindReplace() {
+    delete[] pinned;
+}
+
+FindReplace* FindReplace::create(ReplacePolicy policy, int capacity) {
+    switch (policy) {
+        case ReplacePolicy::CLOCK:
+            return new ClockReplace(capacity);
+        case ReplacePolicy::TWO_QUEUE:
+            return new TwoQueueReplace(capacity);
+        case ReplacePolicy::LRU_K:
+            return new LRUKReplace(capacity);
+        case ReplacePolicy::LRU:
+        default:
+            return new LRUReplace(capacity);
+    }
+}
 
-bool FindReplace::updateCapacity(int capacity_) {
-    if (capacity_ < capacity) {
+bool FindReplace::parsePolicy(const std::string& name, ReplacePolicy& policy) {
+    if (name == "lru") {
+        policy = ReplacePolicy::LRU;
+    } else if (name == "clock") {
+        policy = ReplacePolicy::CLOCK;
+    } else if (name == "2q") {
+        policy = ReplacePolicy::TWO_QUEUE;
+    } else if (name == "lru-k" || name == "lru2") {
+        policy = ReplacePolicy::LRU_K;
+    } else {
         return false;
     }
-    utils::LinkedList<int> *newList = new utils::LinkedList<int>();
-    utils::LinkedListNode<int> **newNode = new utils::LinkedListNode<int>*[capacity_];
+    return true;
+}
+
+const char* FindReplace::policyName(ReplacePolicy policy) {
+    switch (policy) {
+        case ReplacePolicy::CLOCK:
+            return "clock";
+        case ReplacePolicy::TWO_QUEUE:
+            return "2q";
+        case ReplacePolicy::LRU_K:
+            return "lru-k";
+        case ReplacePolicy::LRU:
+        default:
+            return "lru";
+    }
+}
+
+// ---------------------------------------------------------------- FrameQueue
+
+void FrameQueue::pushHead(int index, int* prev, int* next) {
+    prev[index] = -1;
+    next[index] = head;
+    if (head != -1) {
+        prev[head] = index;
+    } else {
+        tail = index;
+    }
+    head = index;
+    ++size;
+}
+
+void FrameQueue::pushTail(int index, int* prev, int* next) {
+    next[index] = -1;
+    prev[index] = tail;
+    if (tail != -1) {
+        next[tail] = index;
+    } else {
+        head = index;
+    }
+    tail = index;
+    ++size;
+}
+
+void FrameQueue::remove(int index, int* prev, int* next) {
+    if (prev[index] != -1) {
+        next[prev[index]] = next[index];
+    } else {
+        head = next[index];
+    }
+    if (next[index] != -1) {
+        prev[next[index]] = prev[index];
+    } else {
+        tail = prev[index];
+    }
+    prev[index] = next[index] = -1;
+    --size;
+}
+
+// ---------------------------------------------------------------- LRU
+
+LRUReplace::LRUReplace(int capacity_) : FindReplace(capacity_) {
+    prev = new int[capacity];
+    next = new int[capacity];
     for (int i = 0; i < capacity; i++) {
-        newList->insertAtHead(i);
-        newNode[i] = newList->getHeadNode();
+        queue.pushHead(i, prev, next);
     }
-    delete list;
-    delete[] node;
-    list = newList;
-    node = newNode;
-    capacity = capacity_;
-    return true;
 }
 
+LRUReplace::~LRUReplace() {
+    delete[] prev;
+    delete[] next;
+}
 
-FindReplace::FindReplace(int capacity_) {
-    capacity = capacity_;  // 设置容量
-    list = new utils::LinkedList<int>();
-    node = new utils::LinkedListNode<int>*[capacity];
+int LRUReplace::find() {
+    int index = queue.tail;
+    while (index != -1 && pinned[index]) {
+        index = prev[index];
+    }
+    if (index == -1) {
+        return -1;
+    }
+    queue.remove(index, prev, next);
+    queue.pushHead(index, prev, next);
+    return index;
+}
+
+void LRUReplace::access(int index) {
+    if (queue.head == index) {
+        return;
+    }
+    queue.remove(index, prev, next);
+    queue.pushHead(index, prev, next);
+}
+
+void LRUReplace::free(int index) {
+    queue.remove(index, prev, next);
+    queue.pushTail(index, prev, next);
+}
+
+int LRUReplace::coldest(int* frames, int limit) const {
+    int count = 0;
+    for (int index = queue.tail; index != -1 && count < limit; index = prev[index]) {
+        frames[count++] = index;
+    }
+    return count;
+}
+
+// ---------------------------------------------------------------- CLOCK
+
+ClockReplace::ClockReplace(int capacity_) : FindReplace(capacity_) {
+    referenced = new uint8_t[capacity];
+    empty = new uint8_t[capacity];
+    freeFrames = new int[capacity];
+    freeCount = 0;
+    for (int i = capacity - 1; i >= 0; i--) {
+        referenced[i] = 0;
+        empty[i] = 1;
+        freeFrames[freeCount++] = i;
+    }
+    hand = 0;
+}
+
+ClockReplace::~ClockReplace() {
+    delete[] referenced;
+    delete[] empty;
+    delete[] freeFrames;
+}
+
+int ClockReplace::find() {
+    int index;
+    if (freeCount > 0) {
+        index = freeFrames[--freeCount];
+        empty[index] = 0;
+    } else if (pinnedCount == capacity) {
+        return -1;
+    } else {
+        while (referenced[hand] || pinned[hand]) {
+            referenced[hand] = 0;
+            hand = hand + 1 == capacity ? 0 : hand + 1;
+        }
+        index = hand;
+        hand = hand + 1 == capacity ? 0 : hand + 1;
+    }
+    referenced[index] = 1;
+    return index;
+}
+
+void ClockReplace::access(int index) {
+    referenced[index] = 1;
+}
+
+void ClockReplace::free(int index) {
+    if (empty[index]) {
+        return;
+    }
+    empty[index] = 1;
+    referenced[index] = 0;
+    freeFrames[freeCount++] = index;
+}
+
+int ClockReplace::coldest(int* frames, int limit) const {
+    // Unreferenced frames ahead of the hand go first, then referenced ones
+    // (they lose their second chance on the next sweep).
+    int count = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0, index = hand; i < capacity && count < limit; i++) {
+            if (!empty[index] && referenced[index] == pass) {
+                frames[count++] = index;
+            }
+            index = index + 1 == capacity ? 0 : index + 1;
+        }
+    }
+    return count;
+}
+
+// ---------------------------------------------------------------- 2Q
+
+TwoQueueReplace::TwoQueueReplace(int capacity_) : FindReplace(capacity_) {
+    prev = new int[capacity];
+    next = new int[capacity];
+    location = new uint8_t[capacity];
     for (int i = 0; i < capacity; i++) {
-        list->insertAtHead(i);
-        node[i] = list->getHeadNode();
+        freeQueue.pushTail(i, prev, next);
+        location[i] = FREE_QUEUE;
     }
+    a1Threshold = capacity / 4 > 0 ? capacity / 4 : 1;
 }
 
-FindReplace::~FindReplace() {
-    delete list;
-    for (int i = 0; i < capacity; i++){
-        node[i] = nullptr;
+TwoQueueReplace::~TwoQueueReplace() {
+    delete[] prev;
+    delete[] next;
+    delete[] location;
+}
+
+int TwoQueueReplace::coldestUnpinned(const FrameQueue& queue) const {
+    int index = queue.tail;
+    while (index != -1 && pinned[index]) {
+        index = prev[index];
+    }
+    return index;
+}
+
+int TwoQueueReplace::find() {
+    int index;
+    if (freeQueue.size > 0) {
+        index = freeQueue.head;
+        freeQueue.remove(index, prev, next);
+    } else {
+        bool fromA1 = a1.size > a1Threshold || am.size == 0;
+        index = coldestUnpinned(fromA1 ? a1 : am);
+        if (index == -1) {
+            fromA1 = !fromA1;
+            index = coldestUnpinned(fromA1 ? a1 : am);
+        }
+        if (index == -1) {
+            return -1;
+        }
+        (fromA1 ? a1 : am).remove(index, prev, next);
+    }
+    a1.pushHead(index, prev, next);
+    location[index] = A1_QUEUE;
+    return index;
+}
+
+void TwoQueueReplace::access(int index) {
+    if (location[index] == A1_QUEUE) {
+        a1.remove(index, prev, next);
+        am.pushHead(index, prev, next);
+        location[index] = AM_QUEUE;
+    } else if (location[index] == AM_QUEUE && am.head != index) {
+        am.remove(index, prev, next);
+        am.pushHead(index, prev, next);
+    }
+}
+
+void TwoQueueReplace::free(int index) {
+    if (location[index] == FREE_QUEUE) {
+        return;
+    }
+    if (location[index] == A1_QUEUE) {
+        a1.remove(index, prev, next);
+    } else {
+        am.remove(index, prev, next);
+    }
+    freeQueue.pushHead(index, prev, next);
+    location[index] = FREE_QUEUE;
+}
+
+int TwoQueueReplace::coldest(int* frames, int limit) const {
+    // Follows find(): A1 drains first while it is over its share.
+    const FrameQueue* order[2] = {&a1, &am};
+    if (a1.size <= a1Threshold && am.size > 0) {
+        order[0] = &am;
+        order[1] = &a1;
+    }
+    int count = 0;
+    for (const FrameQueue* queue : order) {
+        for (int index = queue->tail; index != -1 && count < limit; index = prev[index]) {
+            frames[count++] = index;
+        }
+    }
+    return count;
+}
+
+// ---------------------------------------------------------------- LRU-K
+
+LRUKReplace::LRUKReplace(int capacity_) : FindReplace(capacity_) {
+    history = new uint64_t[capacity * K];
+    heap = new int[capacity];
+    position = new int[capacity];
+    for (int i = 0; i < capacity; i++) {
+        for (int j = 0; j < K; j++) history[i * K + j] = 0;
+        heap[i] = i;
+        position[i] = i;
+    }
+    clock = 0;
+}
+
+LRUKReplace::~LRUKReplace() {
+    delete[] history;
+    delete[] heap;
+    delete[] position;
+}
+
+bool LRUKReplace::less(int a, int b) const {
+    // Older K-th access (larger backward K-distance) is evicted first; a
+    // missing K-th access counts as infinitely old. Ties fall back to LRU.
+    uint64_t ka = history[a * K + K - 1], kb = history[b * K + K - 1];
+    if (ka != kb) return ka < kb;
+    uint64_t la = history[a * K], lb = history[b * K];
+    if (la != lb) return la < lb;
+    return a < b;
+}
+
+void LRUKReplace::swapSlots(int i, int j) {
+    int a = heap[i], b = heap[j];
+    heap[i] = b;
+    heap[j] = a;
+    position[b] = i;
+    position[a] = j;
+}
+
+void LRUKReplace::siftUp(int pos) {
+    while (pos > 0) {
+        int parent = (pos - 1) >> 1;
+        if (!less(heap[pos], heap[parent])) break;
+        swapSlots(pos, parent);
+        pos = parent;
+    }
+}
+
+void LRUKReplace::siftDown(int pos) {
+    while (true) {
+        int left = pos * 2 + 1, right = left + 1, smallest = pos;
+        if (left < capacity && less(heap[left], heap[smallest])) smallest = left;
+        if (right < capacity && less(heap[right], heap[smallest])) smallest = right;
+        if (smallest == pos) break;
+        swapSlots(pos, smallest);
+        pos = smallest;
     }
-    delete[] node;
 }
 
-int FindReplace::find() {
-    int index = list->getTailNode()->value;
-    list->deleteNode(node[index]);
-    node[index] = nullptr;
-    list->insertAtHead(index);
-    node[index] = list->getHeadNode();
+void LRUKReplace::touch(int index) {
+    uint64_t* h = history + index * K;
+    for (int j = K - 1; j > 0; j--) h[j] = h[j - 1];
+    h[0] = ++clock;
+    // The key only grows, so the frame can only move towards the leaves.
+    siftDown(position[index]);
+}
+
+int LRUKReplace::find() {
+    int index = heap[0];
+    if (pinned[index]) {
+        // Pinned frames are rare; fall back to a linear search of the heap.
+        index = -1;
+        for (int pos = 1; pos < capacity; pos++) {
+            int candidate = heap[pos];
+            if (!pinned[candidate] && (index == -1 || less(candidate, index))) {
+                index = candidate;
+            }
+        }
+        if (index == -1) {
+            return -1;
+        }
+    }
+    for (int j = 0; j < K; j++) history[index * K + j] = 0;
+    siftUp(position[index]);
+    touch(index);
     return index;
 }
 
-void FindReplace::access(int index) {
-    list->deleteNode(node[index]);
-    node[index] = nullptr;
-    list->insertAtHead(index);
-    node[index] = list->getHeadNode();
+void LRUKReplace::access(int index) {
+    touch(index);
 }
 
-void FindReplace::free(int index) {
-    list->deleteNode(node[index]);
-    node[index] = nullptr;
-    list->insertAtTail(index);
-    node[index] = list->getTailNode();
+void LRUKReplace::free(int index) {
+    for (int j = 0; j < K; j++) history[index * K + j] = 0;
+    siftUp(position[index]);
+}
+
+int LRUKReplace::coldest(int* frames, int limit) const {
+    // The first heap levels hold the smallest keys; good enough for trickling.
+    int count = 0;
+    for (int pos = 0; pos < capacity && count < limit; pos++) {
+        frames[count++] = heap[pos];
+    }
+    return count;
 }
 
 }  // namespace fs
-}  // namespace dbs
\ No newline at end of file
+}  // namespace dbs
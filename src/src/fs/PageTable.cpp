@@ -0,0 +1,81 @@
+#include "fs/PageTable.hpp"
+
+#include <cassert>
+
+namespace dbs {
+namespace fs {
+
+PageTable::PageTable(int frameCount) {
+    uint32_t capacity = 16;
+    int bits = 4;
+    while (capacity < static_cast<uint32_t>(frameCount) * 2) {
+        capacity <<= 1;
+        ++bits;
+    }
+    slots = new Slot[capacity];
+    mask = capacity - 1;
+    shift = 64 - bits;
+    count = 0;
+    clear();
+}
+
+PageTable::~PageTable() {
+    delete[] slots;
+}
+
+void PageTable::insert(int fileID, int pageID, int pageIndex) {
+    uint64_t key = packKey(fileID, pageID);
+    assert(key != EMPTY_KEY);
+    uint32_t pos = slotOf(key);
+    while (slots[pos].key != EMPTY_KEY) {
+        if (slots[pos].key == key) {
+            slots[pos].value = pageIndex;
+            return;
+        }
+        pos = (pos + 1) & mask;
+    }
+    assert(static_cast<uint32_t>(count) < mask);
+    slots[pos].key = key;
+    slots[pos].value = pageIndex;
+    ++count;
+}
+
+bool PageTable::erase(int fileID, int pageID) {
+    uint64_t key = packKey(fileID, pageID);
+    uint32_t pos = slotOf(key);
+    while (slots[pos].key != key) {
+        if (slots[pos].key == EMPTY_KEY) {
+            return false;
+        }
+        pos = (pos + 1) & mask;
+    }
+
+    // Backward-shift deletion: pull later entries of the same probe run
+    // into the hole so that lookups never need tombstones.
+    uint32_t hole = pos;
+    uint32_t next = (hole + 1) & mask;
+    while (slots[next].key != EMPTY_KEY) {
+        uint32_t home = slotOf(slots[next].key);
+        // Move the entry if its home slot is not in the (hole, next] range.
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            slots[hole] = slots[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    slots[hole].key = EMPTY_KEY;
+    slots[hole].value = -1;
+    --count;
+    return true;
+}
+
+void PageTable::clear() {
+    for (uint32_t i = 0; i <= mask; ++i) {
+        slots[i].key = EMPTY_KEY;
+        slots[i].value = -1;
+    }
+    count = 0;
+}
+
+}  // namespace fs
+}  // namespace dbs
@@ -0,0 +1,382 @@
+#include "fs/ReadAhead.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+namespace dbs {
+namespace fs {
+
+// Minimal io_uring submission/completion rings driven through raw system
+// calls, so the build does not depend on liburing.
+struct UringQueue {
+    int fd = -1;
+    unsigned* sqHead = nullptr;
+    unsigned* sqTail = nullptr;
+    unsigned* sqMask = nullptr;
+    unsigned* sqArray = nullptr;
+    io_uring_sqe* sqes = nullptr;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned* cqMask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+    void* sqRing = MAP_FAILED;
+    size_t sqRingSize = 0;
+    void* cqRing = MAP_FAILED;
+    size_t cqRingSize = 0;
+    size_t sqesSize = 0;
+    std::vector<struct iovec> iovecs;  // one per staging slot
+};
+
+namespace {
+
+void destroyUring(UringQueue* ring) {
+    if (ring == nullptr) return;
+    if (ring->sqes != nullptr) munmap(ring->sqes, ring->sqesSize);
+    if (ring->cqRing != MAP_FAILED && ring->cqRing != ring->sqRing) {
+        munmap(ring->cqRing, ring->cqRingSize);
+    }
+    if (ring->sqRing != MAP_FAILED) munmap(ring->sqRing, ring->sqRingSize);
+    if (ring->fd >= 0) close(ring->fd);
+    delete ring;
+}
+
+UringQueue* createUring(unsigned entries) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    int fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (fd < 0) return nullptr;  // not supported or not permitted
+
+    UringQueue* ring = new UringQueue();
+    ring->fd = fd;
+    ring->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool singleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMap && ring->cqRingSize > ring->sqRingSize) {
+        ring->sqRingSize = ring->cqRingSize;
+    }
+
+    ring->sqRing = mmap(nullptr, ring->sqRingSize, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (ring->sqRing == MAP_FAILED) {
+        destroyUring(ring);
+        return nullptr;
+    }
+    if (singleMap) {
+        ring->cqRing = ring->sqRing;
+    } else {
+        ring->cqRing = mmap(nullptr, ring->cqRingSize, PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (ring->cqRing == MAP_FAILED) {
+            destroyUring(ring);
+            return nullptr;
+        }
+    }
+    ring->sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, ring->sqesSize, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        destroyUring(ring);
+        return nullptr;
+    }
+    ring->sqes = static_cast<io_uring_sqe*>(sqes);
+
+    char* sq = static_cast<char*>(ring->sqRing);
+    ring->sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    ring->sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    ring->sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    ring->sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    char* cq = static_cast<char*>(ring->cqRing);
+    ring->cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    ring->cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    ring->cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    ring->cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    return ring;
+}
+
+int enterUring(UringQueue* ring, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    while (true) {
+        int ret = static_cast<int>(syscall(__NR_io_uring_enter, ring->fd, toSubmit,
+                                           minComplete, flags, nullptr, 0));
+        if (ret >= 0 || errno != EINTR) return ret;
+    }
+}
+
+}  // namespace
+
+ReadAhead::ReadAhead(FileManager* fileMgr, int windowPages, bool allowIoUring) {
+    fileManager = fileMgr;
+    window = windowPages > 0 ? windowPages : 1;
+    staging = static_cast<char*>(
+        std::aligned_alloc(PAGE_SIZE_BY_BYTE, static_cast<size_t>(window) * PAGE_SIZE_BY_BYTE));
+    slots.resize(window);
+    busySlots = 0;
+    nextStream = 0;
+    stopping = false;
+
+    uring = allowIoUring ? createUring(static_cast<unsigned>(window)) : nullptr;
+    if (uring != nullptr) {
+        uring->iovecs.resize(window);
+        for (int i = 0; i < window; i++) {
+            uring->iovecs[i].iov_base = slotBuffer(i);
+            uring->iovecs[i].iov_len = PAGE_SIZE_BY_BYTE;
+        }
+    } else {
+        unsigned hardware = std::thread::hardware_concurrency();
+        int threads = hardware >= 4 ? 4 : 2;
+        for (int i = 0; i < threads; i++) {
+            workers.emplace_back(&ReadAhead::workerLoop, this);
+        }
+    }
+}
+
+ReadAhead::~ReadAhead() {
+    clear();
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        stopping = true;
+    }
+    pending.notify_all();
+    for (auto& worker : workers) worker.join();
+    destroyUring(uring);
+    std::free(staging);
+}
+
+void ReadAhead::setResidencyCheck(std::function<bool(int, int)> isResident_) {
+    std::lock_guard<std::mutex> guard(mutex);
+    isResident = std::move(isResident_);
+}
+
+ReadAhead::Stream* ReadAhead::findStream(int fileID) {
+    for (auto& stream : streams) {
+        if (stream.fileID == fileID) return &stream;
+    }
+    return nullptr;
+}
+
+int ReadAhead::findSlot(int fileID, int pageID) const {
+    for (int i = 0; i < window; i++) {
+        const Slot& slot = slots[i];
+        if (slot.state != SLOT_FREE && slot.fileID == fileID && slot.pageID == pageID) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void ReadAhead::beginScan(int fileID, int firstPageID, int endPageID) {
+    std::unique_lock<std::mutex> lock(mutex);
+    Stream* stream = findStream(fileID);
+    if (stream == nullptr) {
+        streams.push_back(Stream{fileID, firstPageID, endPageID});
+    } else {
+        stream->nextPageID = firstPageID;
+        stream->endPageID = endPageID;
+    }
+    fill();
+}
+
+void ReadAhead::endScan(int fileID) {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (size_t i = 0; i < streams.size(); i++) {
+        if (streams[i].fileID == fileID) {
+            streams.erase(streams.begin() + i);
+            break;
+        }
+    }
+    for (int i = 0; i < window; i++) {
+        if (slots[i].state != SLOT_FREE && slots[i].fileID == fileID) {
+            release(i, lock);
+        }
+    }
+}
+
+bool ReadAhead::take(int fileID, int pageID, BufType buffer) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (busySlots == 0 && streams.empty()) return false;
+
+    Stream* stream = findStream(fileID);
+    if (stream != nullptr) {
+        // Scans move forward: pages behind the consumer will not be asked for.
+        for (int i = 0; i < window; i++) {
+            if (slots[i].state != SLOT_FREE && slots[i].fileID == fileID &&
+                slots[i].pageID < pageID) {
+                release(i, lock);
+            }
+        }
+        if (stream->nextPageID <= pageID) {
+            stream->nextPageID = pageID + 1;
+        }
+    }
+
+    bool staged = false;
+    int slot = findSlot(fileID, pageID);
+    if (slot != -1) {
+        waitFor(slot, lock);
+        if (slots[slot].result >= 0) {
+            std::memcpy(buffer, slotBuffer(slot), slots[slot].result);
+            staged = true;
+        }
+        release(slot, lock);
+    }
+    fill();
+    return staged;
+}
+
+void ReadAhead::invalidate(int fileID, int pageID) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (busySlots == 0) return;
+    int slot = findSlot(fileID, pageID);
+    if (slot != -1) {
+        release(slot, lock);
+    }
+}
+
+void ReadAhead::clear() {
+    std::unique_lock<std::mutex> lock(mutex);
+    streams.clear();
+    for (int i = 0; i < window; i++) {
+        if (slots[i].state != SLOT_FREE) {
+            release(i, lock);
+        }
+    }
+}
+
+void ReadAhead::fill() {
+    if (streams.empty()) return;
+    for (int i = 0; i < window && busySlots < window; i++) {
+        if (slots[i].state != SLOT_FREE) continue;
+
+        // Pick the next page that is neither resident nor already staged,
+        // visiting the active streams round-robin.
+        int chosenFile = -1, chosenPage = -1;
+        for (size_t tried = 0; tried < streams.size() && chosenFile == -1; tried++) {
+            Stream& stream = streams[nextStream % streams.size()];
+            nextStream = (nextStream + 1) % static_cast<int>(streams.size());
+            while (stream.nextPageID < stream.endPageID) {
+                int pageID = stream.nextPageID++;
+                if (findSlot(stream.fileID, pageID) != -1) continue;
+                if (isResident && isResident(stream.fileID, pageID)) continue;
+                chosenFile = stream.fileID;
+                chosenPage = pageID;
+                break;
+            }
+        }
+        if (chosenFile == -1) return;  // every stream is fully staged
+
+        int fd = fileManager->getFileDescriptor(chosenFile);
+        if (fd == -1) return;
+        slots[i].fileID = chosenFile;
+        slots[i].pageID = chosenPage;
+        slots[i].fd = fd;
+        slots[i].state = SLOT_INFLIGHT;
+        slots[i].result = 0;
+        busySlots++;
+        submit(i);
+    }
+}
+
+void ReadAhead::submit(int slot) {
+    off_t offset = static_cast<off_t>(slots[slot].pageID) << PAGE_SIZE_IDX;
+    if (uring != nullptr) {
+        unsigned tail = *uring->sqTail;
+        unsigned index = tail & *uring->sqMask;
+        io_uring_sqe* sqe = &uring->sqes[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_READV;
+        sqe->fd = slots[slot].fd;
+        sqe->addr = reinterpret_cast<unsigned long long>(&uring->iovecs[slot]);
+        sqe->len = 1;
+        sqe->off = offset;
+        sqe->user_data = static_cast<unsigned long long>(slot);
+        uring->sqArray[index] = index;
+        __atomic_store_n(uring->sqTail, tail + 1, __ATOMIC_RELEASE);
+        if (enterUring(uring, 1, 0, 0) < 0) {
+            // Could not hand the request to the kernel; read it right away.
+            slots[slot].result = pread(slots[slot].fd, slotBuffer(slot), PAGE_SIZE_BY_BYTE, offset);
+            slots[slot].state = SLOT_READY;
+        }
+    } else {
+        requests.push_back(slot);
+        pending.notify_one();
+    }
+}
+
+void ReadAhead::reapUring() {
+    unsigned head = *uring->cqHead;
+    unsigned tail = __atomic_load_n(uring->cqTail, __ATOMIC_ACQUIRE);
+    while (head != tail) {
+        io_uring_cqe* cqe = &uring->cqes[head & *uring->cqMask];
+        int slot = static_cast<int>(cqe->user_data);
+        slots[slot].result = cqe->res;
+        slots[slot].state = SLOT_READY;
+        head++;
+    }
+    __atomic_store_n(uring->cqHead, head, __ATOMIC_RELEASE);
+}
+
+void ReadAhead::waitFor(int slot, std::unique_lock<std::mutex>& lock) {
+    if (uring != nullptr) {
+        reapUring();
+        while (slots[slot].state == SLOT_INFLIGHT) {
+            if (enterUring(uring, 0, 1, IORING_ENTER_GETEVENTS) < 0) {
+                break;
+            }
+            reapUring();
+        }
+        if (slots[slot].state == SLOT_INFLIGHT) {
+            // The ring failed underneath us; never hand out this buffer.
+            slots[slot].result = -1;
+            slots[slot].state = SLOT_READY;
+        }
+    } else {
+        completed.wait(lock, [&] { return slots[slot].state != SLOT_INFLIGHT; });
+    }
+}
+
+void ReadAhead::release(int slot, std::unique_lock<std::mutex>& lock) {
+    if (slots[slot].state == SLOT_INFLIGHT && uring == nullptr) {
+        // Not picked up by a worker yet: just withdraw the request.
+        for (auto it = requests.begin(); it != requests.end(); ++it) {
+            if (*it == slot) {
+                requests.erase(it);
+                slots[slot].state = SLOT_READY;
+                break;
+            }
+        }
+    }
+    if (slots[slot].state == SLOT_INFLIGHT) {
+        waitFor(slot, lock);
+    }
+    slots[slot].state = SLOT_FREE;
+    slots[slot].fileID = slots[slot].pageID = -1;
+    busySlots--;
+}
+
+void ReadAhead::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        pending.wait(lock, [&] { return stopping || !requests.empty(); });
+        if (stopping && requests.empty()) return;
+        int slot = requests.front();
+        requests.pop_front();
+        int fd = slots[slot].fd;
+        off_t offset = static_cast<off_t>(slots[slot].pageID) << PAGE_SIZE_IDX;
+        char* buffer = slotBuffer(slot);
+
+        lock.unlock();
+        ssize_t result = pread(fd, buffer, PAGE_SIZE_BY_BYTE, offset);
+        lock.lock();
+
+        slots[slot].result = result;
+        slots[slot].state = SLOT_READY;
+        completed.notify_all();
+    }
+}
+
+}  // namespace fs
+}  // namespace dbs
@@ -0,0 +1,254 @@
+#include "fs/WriteAheadLog.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include "common/Color.hpp"
+
+namespace dbs {
+namespace fs {
+
+namespace {
+
+uint32_t crcTable[256];
+
+void initCrcTable() {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (int j = 0; j < 8; j++) crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1)));
+        crcTable[i] = crc;
+    }
+}
+
+uint32_t crc32(uint32_t crc, const char* data, size_t length) {
+    static bool ready = (initCrcTable(), true);
+    (void)ready;
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) {
+        crc = crcTable[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+bool writeAll(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(fd, data, length);
+        if (written <= 0) return false;
+        data += written;
+        length -= written;
+    }
+    return true;
+}
+
+// Creates every missing folder on the way to `filePath`
+void createParents(FileManager* fileMgr, const std::string& filePath) {
+    for (size_t slash = filePath.find('/', 1); slash != std::string::npos;
+         slash = filePath.find('/', slash + 1)) {
+        std::string folder = filePath.substr(0, slash);
+        if (folder != "." && !fileMgr->doesFolderExist(folder.c_str())) {
+            fileMgr->createFolder(folder.c_str());
+        }
+    }
+}
+
+}  // namespace
+
+WriteAheadLog::WriteAheadLog() {
+    fd = -1;
+    nextLSN = 1;
+    writtenLSN = 0;
+    syncedLSN = 0;
+    logBytes = 0;
+    fileBytes = 0;
+    flushing = false;
+    failed = false;
+}
+
+WriteAheadLog::~WriteAheadLog() {
+    if (fd != -1) {
+        flush(lastLSN(), true);
+        close(fd);
+    }
+}
+
+int WriteAheadLog::recover(const char* path, FileManager* fileMgr) {
+    int logFd = ::open(path, O_RDWR);
+    if (logFd == -1) return 0;  // no log, nothing to do
+
+    // Page images are written through the FileManager, which may use O_DIRECT.
+    char* data = static_cast<char*>(std::aligned_alloc(DIRECT_IO_ALIGNMENT, PAGE_SIZE_BY_BYTE));
+    RecordHeader header;
+    std::string recordPath;
+    off_t offset = 0;
+    int replayed = 0;
+    while (pread(logFd, &header, sizeof(header), offset) == sizeof(header)) {
+        if (header.magic != RECORD_MAGIC || header.pathLength == 0 || header.pathLength > 4096 ||
+            header.dataLength > PAGE_SIZE_BY_BYTE) {
+            break;
+        }
+        recordPath.resize(header.pathLength);
+        off_t body = offset + sizeof(header);
+        if (pread(logFd, &recordPath[0], header.pathLength, body) != header.pathLength ||
+            pread(logFd, data, header.dataLength, body + header.pathLength) !=
+                static_cast<ssize_t>(header.dataLength)) {
+            break;  // torn tail
+        }
+        uint32_t checksum = header.checksum;
+        header.checksum = 0;
+        uint32_t crc = crc32(0, reinterpret_cast<const char*>(&header), sizeof(header));
+        crc = crc32(crc, recordPath.data(), recordPath.size());
+        crc = crc32(crc, data, header.dataLength);
+        if (crc != checksum) break;
+
+        if (header.type == RECORD_PAGE && header.dataLength == PAGE_SIZE_BY_BYTE) {
+            if (!fileMgr->doesFileExist(recordPath.c_str())) {
+                createParents(fileMgr, recordPath);
+                fileMgr->createFile(recordPath.c_str());
+            }
+            int fileID = fileMgr->openFile(recordPath.c_str());
+            if (fileID != -1) {
+                fileMgr->writePage(fileID, header.pageID, reinterpret_cast<BufType>(data), 0);
+                fileMgr->closeFile(fileID);
+            }
+        } else if (header.type == RECORD_DELETE) {
+            if (fileMgr->doesFolderExist(recordPath.c_str())) {
+                fileMgr->deleteFolder(recordPath.c_str());
+            } else if (fileMgr->doesFileExist(recordPath.c_str())) {
+                fileMgr->deleteFile(recordPath.c_str());
+            }
+        }
+        replayed++;
+        offset = body + header.pathLength + header.dataLength;
+    }
+    std::free(data);
+
+    if (replayed > 0) {
+        std::cerr << Color::WARNING << "Recovered " << replayed
+                  << " records from the write-ahead log" << Color::ENDC << std::endl;
+    }
+    syncfs(logFd);
+    if (ftruncate(logFd, 0) != 0 || fsync(logFd) != 0) {
+        std::cerr << Color::FAIL << "DB failed to reset the write-ahead log: " << path
+                  << Color::ENDC << std::endl;
+    }
+    close(logFd);
+    return replayed;
+}
+
+bool WriteAheadLog::open(const char* path) {
+    fd = ::open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (fd == -1) {
+        std::cerr << Color::FAIL << "DB failed to open the write-ahead log: " << path
+                  << Color::ENDC << std::endl;
+        return false;
+    }
+    struct stat logInfo;
+    if (fstat(fd, &logInfo) == 0) logBytes = fileBytes = logInfo.st_size;
+    return true;
+}
+
+uint64_t WriteAheadLog::append(RecordType type, const std::string& path, int pageID,
+                               const char* data, uint32_t dataLength) {
+    RecordHeader header;
+    header.magic = RECORD_MAGIC;
+    header.type = type;
+    header.pathLength = static_cast<uint32_t>(path.size());
+    header.pageID = pageID;
+    header.dataLength = dataLength;
+    header.checksum = 0;
+
+    std::lock_guard<std::mutex> guard(mutex);
+    header.lsn = nextLSN++;
+    uint32_t crc = crc32(0, reinterpret_cast<const char*>(&header), sizeof(header));
+    crc = crc32(crc, path.data(), path.size());
+    header.checksum = crc32(crc, data, dataLength);
+
+    const char* raw = reinterpret_cast<const char*>(&header);
+    pending.insert(pending.end(), raw, raw + sizeof(header));
+    pending.insert(pending.end(), path.begin(), path.end());
+    pending.insert(pending.end(), data, data + dataLength);
+    logBytes += sizeof(header) + path.size() + dataLength;
+    return header.lsn;
+}
+
+uint64_t WriteAheadLog::appendPage(const std::string& filePath, int pageID, const BufType page) {
+    return append(RECORD_PAGE, filePath, pageID, reinterpret_cast<const char*>(page),
+                  PAGE_SIZE_BY_BYTE);
+}
+
+uint64_t WriteAheadLog::appendDelete(const std::string& path) {
+    return append(RECORD_DELETE, path, -1, nullptr, 0);
+}
+
+bool WriteAheadLog::flush(uint64_t lsn, bool sync) {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        if (failed) return false;
+        if ((sync ? syncedLSN : writtenLSN) >= lsn) return true;
+        if (!flushing) break;
+        flushed.wait(lock);  // the current leader may cover us
+    }
+    // Become the leader: write out everything appended so far.
+    flushing = true;
+    std::vector<char> batch;
+    batch.swap(pending);
+    uint64_t batchEnd = nextLSN - 1;
+    lock.unlock();
+
+    bool ok = writeAll(fd, batch.data(), batch.size());
+    if (ok && sync) ok = fdatasync(fd) == 0;
+    if (!ok) {
+        std::cerr << Color::FAIL << "DB failed to write the write-ahead log: "
+                  << std::strerror(errno) << Color::ENDC << std::endl;
+    }
+
+    lock.lock();
+    if (ok) {
+        fileBytes += batch.size();
+        writtenLSN = batchEnd;
+        if (sync) syncedLSN = batchEnd;
+    } else {
+        // A failed fdatasync may have dropped dirty log pages, so nothing
+        // after syncedLSN can be trusted again. Cut off whatever part of the
+        // batch reached the file so that recovery does not replay half a
+        // statement that was reported as failed.
+        failed = true;
+        if (ftruncate(fd, fileBytes) != 0) {
+            std::cerr << Color::FAIL << "DB failed to discard a partly written log batch"
+                      << Color::ENDC << std::endl;
+        }
+    }
+    flushing = false;
+    flushed.notify_all();
+    return ok;
+}
+
+void WriteAheadLog::syncDataFiles() {
+    if (fd != -1) syncfs(fd);
+}
+
+void WriteAheadLog::truncate() {
+    std::unique_lock<std::mutex> lock(mutex);
+    flushed.wait(lock, [this] { return !flushing; });
+    pending.clear();
+    writtenLSN = syncedLSN = nextLSN - 1;
+    logBytes = fileBytes = 0;
+    if (ftruncate(fd, 0) != 0 || fdatasync(fd) != 0) {
+        std::cerr << Color::FAIL << "DB failed to truncate the write-ahead log" << Color::ENDC
+                  << std::endl;
+    }
+}
+
+uint64_t WriteAheadLog::lastLSN() {
+    std::lock_guard<std::mutex> guard(mutex);
+    return nextLSN - 1;
+}
+
+uint64_t WriteAheadLog::sizeBytes() {
+    std::lock_guard<std::mutex> guard(mutex);
+    return logBytes;
+}
+
+}  // namespace fs
+}  // namespace dbs
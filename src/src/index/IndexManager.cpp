@@ -1,78 +1,35 @@
 #include "index/IndexManager.hpp"
 
+#include <algorithm>
+#include <cstring>
+
 namespace dbs {
 namespace index {
 
-IndexManager::IndexManager(fs::FileManager* fm_, fs::BufPageManager* bpm_) {
+IndexManager::IndexManager(fs::FileManager* fm_, fs::BufPageManager* bpm_,
+                           fs::FileHandleCache* files_) {
     fm = fm_;
     bpm = bpm_;
-    current_opening_file_paths.clear();
-    current_opening_file_ids.clear();
+    owns_files = files_ == nullptr;
+    files = owns_files ? new fs::FileHandleCache(fm, bpm) : files_;
 }
 
 IndexManager::~IndexManager() {
     closeAllCurrentFile();
+    if (owns_files) delete files;
+    files = nullptr;
     fm = nullptr;
     bpm = nullptr;
 }
 
-void IndexManager::closeAllCurrentFile() {
-    bpm->closeManager();
-    for (auto& file_path : current_opening_file_paths) {
-        delete[] file_path;
-        file_path = nullptr;
-    }
-    current_opening_file_paths.clear();
-    for (auto& file_id : current_opening_file_ids) {
-        fm->closeFile(file_id);
-    }
-    current_opening_file_ids.clear();
-}
+void IndexManager::closeAllCurrentFile() { files->closeAll(); }
 
 void IndexManager::closeFileIfOpen(const char* file_path) {
-    int current_opening_file_num = current_opening_file_paths.size();
-    for (int i = 0; i < current_opening_file_num; i++) {
-        if (strcmp(current_opening_file_paths[i], file_path) == 0) {
-            int file_id = current_opening_file_ids[i];
-            bpm->closeManager();
-            fm->closeFile(file_id);
-            delete[] current_opening_file_paths[i];
-            current_opening_file_paths[i] = nullptr;
-            current_opening_file_paths.erase(
-                current_opening_file_paths.begin() + i);
-            current_opening_file_ids.erase(current_opening_file_ids.begin() +
-                                           i);
-            return;
-        }
-    }
-}
-
-void IndexManager::closeFirstFile() {
-    if (current_opening_file_ids.size() == 0) return;
-    int file_id = current_opening_file_ids.front();
-    current_opening_file_ids.erase(current_opening_file_ids.begin());
-    bpm->closeManager();
-    fm->closeFile(file_id);
-    delete[] current_opening_file_paths.front();
-    current_opening_file_paths.front() = nullptr;
-    current_opening_file_paths.erase(current_opening_file_paths.begin());
+    files->close(file_path);
 }
 
 int IndexManager::openFile(const char* file_path) {
-    int current_opening_file_num = current_opening_file_paths.size();
-    for (int i = 0; i < current_opening_file_num; i++) {
-        if (strcmp(current_opening_file_paths[i], file_path) == 0) {
-            return current_opening_file_ids[i];
-        }
-    }
-    if (current_opening_file_num == cacheCapacity) {
-        closeFirstFile();
-    }
-    current_opening_file_paths.push_back(new char[strlen(file_path) + 1]);
-    strcpy(current_opening_file_paths.back(), file_path);
-    int file_id = fm->openFile(file_path);
-    current_opening_file_ids.push_back(file_id);
-    return file_id;
+    return files->open(file_path);
 }
 
 void IndexManager::createEmptyBitMapPage(int file_id, int pageId) {
@@ -335,6 +292,143 @@ bool IndexManager::insertIndex(const char* file_path,
     return true;
 }
 
+bool IndexManager::bulkBuildIndex(const char* file_path, int index_key_num,
+                                  IndexSorter& entries, bool unique,
+                                  int fill_percent) {
+    initializeIndexFile(file_path, index_key_num);
+    if (!entries.finish()) {
+        initializeIndexFile(file_path, index_key_num);
+        return false;
+    }
+    if (entries.size() == 0) return true;
+
+    int file_id = openFile(file_path);
+    assert(file_id != -1);
+    int m = getBPlusTreeM(index_key_num);
+    int per_node =
+        std::min(m, std::max((m + 1) / 2, m * fill_percent / 100));
+
+    // 页号顺序分配，跳过之后的bitmap页所在位置
+    int bitmap_span = INDEX_BITMAP_PAGE_BYTE_LEN * BIT_PER_BYTE;
+    int next_pageId = 2;
+    auto allocate = [&]() {
+        if (next_pageId % bitmap_span == 0) next_pageId++;
+        return next_pageId++;
+    };
+
+    std::vector<unsigned int> page(BUF_PER_PAGE);
+    auto writePage = [&](int pageId) {
+        int index;
+        BufType b = bpm->getPage(file_id, pageId, index);
+        memcpy(b, page.data(), PAGE_SIZE_BY_BYTE);
+        bpm->markPageDirty(index);
+    };
+    auto startPage = [&](const std::vector<int>& pageIds, int i, int size,
+                         bool leaf) {
+        std::fill(page.begin(), page.end(), 0);
+        int last_node = pageIds.size() - 1;
+        page[0] = i == 0 ? -1 : pageIds[i - 1];          // 上一个同级节点页号
+        page[1] = i == last_node ? -1 : pageIds[i + 1];  // 下一个同级节点页号
+        page[2] = size;  // 子节点数量
+        page[3] = leaf;  // 是否是叶节点
+    };
+
+    // 叶节点，同时记下每个叶节点的页号和最大键作为上一层的子节点
+    int child_len = index_key_num + 1;
+    std::vector<int> children;
+    std::vector<int> sizes = bulkNodeSizes(entries.size(), per_node, m);
+    std::vector<int> pageIds(sizes.size());
+    for (auto& pageId : pageIds) pageId = allocate();
+    IndexSortEntry entry, last;
+    for (int i = 0; i < sizes.size(); i++) {
+        startPage(pageIds, i, sizes[i], true);
+        int buf_offset = INDEX_HEADER_BYTE_LEN >> LOG_BYTE_PER_BUF;
+        for (int j = 0; j < sizes[i]; j++) {
+            bool first = i == 0 && j == 0;
+            if (!entries.next(entry) ||
+                (unique && !first && entry.sameKey(last))) {
+                initializeIndexFile(file_path, index_key_num);
+                return false;
+            }
+            page[buf_offset++] = entry.pageId;
+            page[buf_offset++] = entry.slotId;
+            for (int k = 0; k < index_key_num; k++) {
+                page[buf_offset++] = entry.key[k];
+            }
+            last = entry;
+        }
+        writePage(pageIds[i]);
+        children.push_back(pageIds[i]);
+        children.insert(children.end(), last.key, last.key + index_key_num);
+    }
+
+    // 自底向上逐层建立内部节点，根节点总是内部节点
+    do {
+        int child_num = children.size() / child_len;
+        sizes = bulkNodeSizes(child_num, per_node, m);
+        pageIds.resize(sizes.size());
+        for (auto& pageId : pageIds) pageId = allocate();
+        std::vector<int> parents;
+        const int* child = children.data();
+        for (int i = 0; i < sizes.size(); i++) {
+            startPage(pageIds, i, sizes[i], false);
+            int buf_offset = INDEX_HEADER_BYTE_LEN >> LOG_BYTE_PER_BUF;
+            for (int j = 0; j < sizes[i]; j++) {
+                for (int k = 0; k < child_len; k++) {
+                    page[buf_offset++] = child[k];
+                }
+                child += child_len;
+            }
+            writePage(pageIds[i]);
+            parents.push_back(pageIds[i]);
+            parents.insert(parents.end(), child - index_key_num, child);
+        }
+        children.swap(parents);
+    } while (children.size() > (size_t)child_len);
+
+    int index;
+    BufType b = bpm->getPage(file_id, 0, index);
+    b[1] = children[0];  // 根节点
+    bpm->markPageDirty(index);
+    writeFullBitMapPages(file_id, next_pageId - 1);
+    return true;
+}
+
+std::vector<int> IndexManager::bulkNodeSizes(size_t item_num, int per_node,
+                                             int b_plus_tree_m) {
+    std::vector<int> sizes(item_num / per_node, per_node);
+    int rest = item_num % per_node;
+    if (rest == 0) return sizes;
+    if (sizes.empty() || rest >= (b_plus_tree_m + 1) / 2) {
+        sizes.push_back(rest);
+    } else {
+        int merged = sizes.back() + rest;
+        if (merged <= b_plus_tree_m) {
+            sizes.back() = merged;
+        } else {
+            sizes.back() = merged / 2;
+            sizes.push_back(merged - merged / 2);
+        }
+    }
+    return sizes;
+}
+
+void IndexManager::writeFullBitMapPages(int file_id, int last_pageId) {
+    // 第k个bitmap页位于k * span（第0个在第1页），记录[k * span, (k + 1) * span)
+    int bitmap_span = INDEX_BITMAP_PAGE_BYTE_LEN * BIT_PER_BYTE;
+    int bitmap_num = last_pageId / bitmap_span + 1;
+    for (int k = 0; k < bitmap_num; k++) {
+        int pageId = k == 0 ? 1 : k * bitmap_span;
+        createEmptyBitMapPage(file_id, pageId);
+        int index;
+        BufType b = bpm->getPage(file_id, pageId, index);
+        int used = std::min(bitmap_span, last_pageId - k * bitmap_span + 1);
+        for (int i = 0; i < used; i++) utils::setBitInBuffer(b, i, true);
+        b[BUF_PER_PAGE - 1] = k + 1 < bitmap_num ? (k + 1) * bitmap_span : -1;
+        bpm->markPageDirty(index);
+    }
+}
+
 bool IndexManager::internalNodeOverflow_(
     int file_id, int pageId, BPlusTreeInternalNode& node,
     const std::list<dbs::index::BPlusTreeInternalChild>::iterator& insert_pos,
@@ -460,9 +554,9 @@ void IndexManager::splitLeafNode(BPlusTreeLeafNode& origin_node,
 void IndexManager::insertNode(int file_id, int pageId,
                               const BPlusTreeLeafChild& insert_item,
                               int index_key_num, int b_plus_tree_m) {
-    BufType b;
-    int index;
-    b = bpm->getPage(file_id, pageId, index);
+    // 整个插入过程中固定本节点页面，写回时无需重新获取
+    fs::PageGuard page(bpm, file_id, pageId);
+    BufType b = page.data();
     bool is_leaf = b[3];
     if (is_leaf) {
         // 如果是叶节点
@@ -470,7 +564,6 @@ void IndexManager::insertNode(int file_id, int pageId,
         // 读取节点
         BPlusTreeLeafNode node;
         readBPlusTreeLeafNodeFromPage(b, node, index_key_num);
-        bpm->accessPage(index);
 
         // 插入
         auto child_itr = node.children.begin();
@@ -489,9 +582,8 @@ void IndexManager::insertNode(int file_id, int pageId,
                                b_plus_tree_m);
 
         // 写回
-        b = bpm->getPage(file_id, pageId, index);
         writeBPlusTreeLeafNode2Page(b, node, index_key_num);
-        bpm->markPageDirty(index);
+        page.markDirty();
         return;
     } else {
         // 不是叶节点
@@ -499,7 +591,6 @@ void IndexManager::insertNode(int file_id, int pageId,
         // 读取节点
         BPlusTreeInternalNode node;
         readBPlusTreeInternalNodeFromPage(b, node, index_key_num);
-        bpm->accessPage(index);
 
         // 插入
         for (auto child_itr = node.children.begin();
@@ -514,9 +605,8 @@ void IndexManager::insertNode(int file_id, int pageId,
                                                child_itr, index_key_num,
                                                b_plus_tree_m)) {
                     // 如有必要，写回
-                    b = bpm->getPage(file_id, pageId, index);
                     writeBPlusTreeInternalNode2Page(b, node, index_key_num);
-                    bpm->markPageDirty(index);
+                    page.markDirty();
                 }
                 return;
             }
@@ -534,9 +624,8 @@ void IndexManager::insertNode(int file_id, int pageId,
                                    index_key_num, b_plus_tree_m);
 
         // 写回
-        b = bpm->getPage(file_id, pageId, index);
         writeBPlusTreeInternalNode2Page(b, node, index_key_num);
-        bpm->markPageDirty(index);
+        page.markDirty();
     }
 }
 
@@ -560,7 +649,7 @@ bool IndexManager::searchIndexInRanges(
     // meta info
     BufType b;
     int index;
-    b = bpm->getPage(file_id, 0, index);
+    b = bpm->getPageReadOnly(file_id, 0, index);
     int index_key_num = b[0];
     int root_pageId = b[1];
     bpm->accessPage(index);
@@ -590,7 +679,7 @@ bool IndexManager::searchLeafNode(int file_id, int pageId,
                               BPlusTreeLeafNode& leaf_result) {
     BufType b;
     int index;
-    b = bpm->getPage(file_id, pageId, index);
+    b = bpm->getPageReadOnly(file_id, pageId, index);
     bool is_leaf = b[3];  // Check if the current node is a leaf.
     if (is_leaf) {
         // If it's a leaf node, read the leaf node and search for the value.
@@ -648,7 +737,7 @@ void IndexManager::searchForward(int file_id,
     if (base_node.nextPageId == -1) return;
     BufType b;
     int index;
-    b = bpm->getPage(file_id, base_node.nextPageId, index);
+    b = bpm->getPageReadOnly(file_id, base_node.nextPageId, index);
     BPlusTreeLeafNode next_node;
     readBPlusTreeLeafNodeFromPage(b, next_node, index_key_num);
     bpm->accessPage(index);
@@ -0,0 +1,127 @@
+#include "index/IndexSorter.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace dbs {
+namespace index {
+
+namespace {
+
+const size_t RUN_READ_ENTRIES = 4096;  // entries read from a run at a time
+
+}  // namespace
+
+bool IndexSortEntry::operator<(const IndexSortEntry& other) const {
+    for (int i = 0; i < INDEX_KEY_MAX_NUM; i++) {
+        if (key[i] != other.key[i]) return key[i] < other.key[i];
+    }
+    if (pageId != other.pageId) return pageId > other.pageId;
+    return slotId > other.slotId;
+}
+
+bool IndexSortEntry::sameKey(const IndexSortEntry& other) const {
+    return memcmp(key, other.key, sizeof(key)) == 0;
+}
+
+IndexSorter::IndexSorter(const char* spill_prefix, size_t memory_bytes)
+    : prefix(spill_prefix), count(0), ioFailed(false), position(0) {
+    capacity = std::max<size_t>(1, memory_bytes / sizeof(IndexSortEntry));
+}
+
+IndexSorter::~IndexSorter() {
+    for (auto& run : runs) {
+        if (run.file != nullptr) fclose(run.file);
+    }
+    for (auto& path : runPaths) std::remove(path.c_str());
+}
+
+void IndexSorter::add(int page_id, int slot_id, const int* keys, int key_num) {
+    if (entries.size() == capacity) spill();
+    IndexSortEntry entry;
+    memset(entry.key, 0, sizeof(entry.key));
+    memcpy(entry.key, keys, key_num * sizeof(int));
+    entry.pageId = page_id;
+    entry.slotId = slot_id;
+    entries.push_back(entry);
+    count++;
+}
+
+void IndexSorter::spill() {
+    std::sort(entries.begin(), entries.end());
+    std::string path = prefix + ".run" + std::to_string(runPaths.size());
+    runPaths.push_back(path);
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr ||
+        fwrite(entries.data(), sizeof(IndexSortEntry), entries.size(), file) !=
+            entries.size()) {
+        ioFailed = true;
+    }
+    if (file != nullptr) fclose(file);
+    entries.clear();
+}
+
+bool IndexSorter::finish() {
+    if (runPaths.empty()) {
+        std::sort(entries.begin(), entries.end());
+        position = 0;
+        return true;
+    }
+    if (!entries.empty()) spill();
+    std::vector<IndexSortEntry>().swap(entries);
+    if (ioFailed) return false;
+
+    runs.resize(runPaths.size());
+    for (int i = 0; i < runs.size(); i++) {
+        runs[i].file = fopen(runPaths[i].c_str(), "rb");
+        runs[i].position = 0;
+        if (runs[i].file == nullptr) ioFailed = true;
+    }
+    if (ioFailed) return false;
+
+    auto later = [this](int a, int b) {
+        return runs[b].buffer[runs[b].position] <
+               runs[a].buffer[runs[a].position];
+    };
+    for (int i = 0; i < runs.size(); i++) {
+        if (refill(runs[i])) heap.push_back(i);
+    }
+    std::make_heap(heap.begin(), heap.end(), later);
+    return !ioFailed;
+}
+
+bool IndexSorter::refill(Run& run) {
+    run.buffer.resize(RUN_READ_ENTRIES);
+    size_t read = fread(run.buffer.data(), sizeof(IndexSortEntry),
+                        RUN_READ_ENTRIES, run.file);
+    if (read < RUN_READ_ENTRIES && ferror(run.file)) ioFailed = true;
+    run.buffer.resize(read);
+    run.position = 0;
+    return read > 0;
+}
+
+bool IndexSorter::next(IndexSortEntry& entry) {
+    if (runs.empty()) {
+        if (position == entries.size()) return false;
+        entry = entries[position++];
+        return true;
+    }
+    if (heap.empty() || ioFailed) return false;
+
+    auto later = [this](int a, int b) {
+        return runs[b].buffer[runs[b].position] <
+               runs[a].buffer[runs[a].position];
+    };
+    std::pop_heap(heap.begin(), heap.end(), later);
+    Run& run = runs[heap.back()];
+    entry = run.buffer[run.position++];
+    if (run.position < run.buffer.size() || refill(run)) {
+        std::push_heap(heap.begin(), heap.end(), later);
+    } else {
+        heap.pop_back();
+    }
+    return !ioFailed;
+}
+
+}  // namespace index
+}  // namespace dbs
@@ -3,7 +3,53 @@
 namespace dbs {
 namespace parser {
 
+namespace {
+
+// True if `sql` is the single statement "<words...> [argument];"; the
+// argument is required iff `argument` is given
+bool matchStatement(const std::string& sql, std::initializer_list<const char*> words,
+                    std::string* argument = nullptr) {
+    size_t end = sql.find(';');
+    if (end == std::string::npos ||
+        sql.find_first_not_of(" \t\r\n", end + 1) != std::string::npos) {
+        return false;
+    }
+    std::istringstream stream(sql.substr(0, end));
+    std::string word;
+    for (const char* expected : words) {
+        if (!(stream >> word) || word != expected) return false;
+    }
+    if (argument != nullptr && !(stream >> *argument)) return false;
+    return !(stream >> word);
+}
+
+}  // namespace
+
 bool Parser::parse(std::string sSQL) {
+    // Administrative statements, handled before ANTLR (see Parser.hpp)
+    bool show_buffer = matchStatement(sSQL, {"SHOW", "BUFFER", "STATUS"});
+    if (show_buffer || matchStatement(sSQL, {"RESET", "BUFFER", "STATUS"})) {
+        auto start_time = std::chrono::high_resolution_clock::now();
+        SQLMyVisitor iVisitor{SQLMyVisitor(rm, im, sm, output_mode, bpm)};
+        auto res = show_buffer ? iVisitor.showBufferStatus()
+                               : iVisitor.resetBufferStatus();
+        return std::any_cast<bool>(iVisitor.finishProgram(res, start_time));
+    }
+    std::string durability;
+    if (matchStatement(sSQL, {"SET", "DURABILITY"}, &durability)) {
+        auto start_time = std::chrono::high_resolution_clock::now();
+        SQLMyVisitor iVisitor{SQLMyVisitor(rm, im, sm, output_mode, bpm)};
+        auto res = iVisitor.setDurability(durability);
+        return std::any_cast<bool>(iVisitor.finishProgram(res, start_time));
+    }
+    std::string record_format;
+    if (matchStatement(sSQL, {"SET", "RECORD", "FORMAT"}, &record_format)) {
+        auto start_time = std::chrono::high_resolution_clock::now();
+        SQLMyVisitor iVisitor{SQLMyVisitor(rm, im, sm, output_mode, bpm)};
+        auto res = iVisitor.setRecordFormat(record_format);
+        return std::any_cast<bool>(iVisitor.finishProgram(res, start_time));
+    }
+
     // to input stream
     antlr4::ANTLRInputStream sInputStream(sSQL);
     // setup lexer
@@ -24,16 +70,17 @@ bool Parser::parse(std::string sSQL) {
     }
 
     // setup visitor
-    SQLMyVisitor iVisitor{SQLMyVisitor(rm, im, sm, output_mode)};
+    SQLMyVisitor iVisitor{SQLMyVisitor(rm, im, sm, output_mode, bpm)};
     auto res = iVisitor.visit(iTree);
     return std::any_cast<bool>(res);
 }
 
 Parser::Parser(record::RecordManager* rm_, index::IndexManager* im_,
-               system::SystemManager* sm_) {
+               system::SystemManager* sm_, fs::BufPageManager* bpm_) {
     rm = rm_;
     im = im_;
     sm = sm_;
+    bpm = bpm_;
 }
 
 void Parser::setOutputMode(bool mode) { output_mode = mode; }
@@ -42,6 +89,7 @@ Parser::~Parser() {
     rm = nullptr;
     im = nullptr;
     sm = nullptr;
+    bpm = nullptr;
 }
 
 }  // namespace parser
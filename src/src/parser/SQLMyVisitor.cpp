@@ -24,6 +24,24 @@ struct JoinEdge {
     }
 };
 
+void maskColumnId(record::ColumnMask& column_mask, int column_id) {
+    if (column_mask.size() <= column_id) column_mask.resize(column_id + 1, false);
+    column_mask[column_id] = true;
+}
+
+// Adds a column, by name, to a scan's column mask. Returns false if the table
+// has no such column (e.g. "*"); the scan then has to decode every column.
+bool maskColumn(const std::vector<record::ColumnType>& column_types,
+                const std::string& column_name, record::ColumnMask& column_mask) {
+    for (auto& column_type : column_types) {
+        if (column_type.columnName == column_name) {
+            maskColumnId(column_mask, column_type.columnId);
+            return true;
+        }
+    }
+    return false;
+}
+
 ParseResult::ParseResult() {
     columns.clear();
     data_items.clear();
@@ -200,10 +218,12 @@ void ParseResult::print(bool output_mode, int duration) {
 }
 
 SQLMyVisitor::SQLMyVisitor(record::RecordManager* rm_, index::IndexManager* im_,
-                           system::SystemManager* sm_, bool output_mode_) {
+                           system::SystemManager* sm_, bool output_mode_,
+                           fs::BufPageManager* bpm_) {
     rm = rm_;
     im = im_;
     sm = sm_;
+    bpm = bpm_;
     output_mode = output_mode_;
 }
 
@@ -211,11 +231,16 @@ SQLMyVisitor::~SQLMyVisitor() {
     rm = nullptr;
     im = nullptr;
     sm = nullptr;
+    bpm = nullptr;
 }
 
 std::any SQLMyVisitor::visitProgram(antlr4::SQLParser::ProgramContext* ctx) {
     auto start_time = std::chrono::high_resolution_clock::now();
-    auto res = visitChildren(ctx);
+    return finishProgram(visitChildren(ctx), start_time);
+}
+
+std::any SQLMyVisitor::finishProgram(
+    std::any res, std::chrono::high_resolution_clock::time_point start_time) {
     if (res.type() == typeid(ParseResult)) {
         auto end_time = std::chrono::high_resolution_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -281,6 +306,89 @@ std::any SQLMyVisitor::visitShow_tables(
     return ParseResult(column_types, table_names);
 }
 
+std::any SQLMyVisitor::showBufferStatus() {
+    if (bpm == nullptr) return false;
+    fs::BufferPoolStats stats;
+    bpm->getStats(stats);
+
+    std::vector<record::ColumnType> column_types;
+    const char* names[] = {"FILE",         "HITS",       "MISSES",
+                           "HIT_RATIO",    "EVICTIONS",  "DIRTY_WRITES",
+                           "READ_BYTES",   "WRITE_BYTES", "BG_WRITES",
+                           "MAPPED_READS"};
+    for (const char* name : names) {
+        record::ColumnType column(record::DataTypeIdentifier::VARCHAR, 255, 0,
+                                  true, false, record::DefaultValue(), name);
+        column.columnId = column_types.size();
+        column_types.push_back(column);
+    }
+
+    std::vector<record::DataItem> rows;
+    auto add_row = [&](const std::string& file, const fs::BufferStats& s,
+                       const std::string& bg_writes,
+                       const std::string& mapped_reads) {
+        uint64_t requests = s.hits + s.misses;
+        std::ostringstream ratio;
+        ratio << std::fixed << std::setprecision(2)
+              << (requests == 0 ? 0.0 : 100.0 * s.hits / requests) << "%";
+        std::vector<std::string> values = {
+            file,
+            std::to_string(s.hits),
+            std::to_string(s.misses),
+            ratio.str(),
+            std::to_string(s.evictions),
+            std::to_string(s.dirtyWrites),
+            std::to_string(s.readBytes),
+            std::to_string(s.writeBytes),
+            bg_writes,
+            mapped_reads};
+        record::DataItem row;
+        for (size_t i = 0; i < values.size(); i++) {
+            row.values.push_back(record::DataValue(
+                record::DataTypeIdentifier::VARCHAR, false, values[i]));
+            row.columnIds.push_back(i);
+        }
+        row.dataId = rows.size();
+        rows.push_back(row);
+    };
+    add_row("TOTAL", stats.total, std::to_string(stats.backgroundWrites),
+            std::to_string(stats.mappedReads));
+    for (auto& file : stats.files) {
+        add_row(file.first, file.second, "-", "-");
+    }
+    return ParseResult(column_types, rows);
+}
+
+std::any SQLMyVisitor::resetBufferStatus() {
+    if (bpm == nullptr) return false;
+    bpm->resetStats();
+    return true;
+}
+
+std::any SQLMyVisitor::setDurability(const std::string& mode) {
+    fs::Durability durability;
+    if (bpm == nullptr || !fs::BufPageManager::parseDurability(mode, durability)) {
+        std::cout << "!ERROR" << std::endl;
+        std::cout << "Unknown durability mode: " << mode
+                  << " (expected OFF, PERIODIC or STRICT)" << std::endl;
+        return false;
+    }
+    bpm->setDurability(durability);
+    return true;
+}
+
+std::any SQLMyVisitor::setRecordFormat(const std::string& format) {
+    record::RecordFormat record_format;
+    if (!record::parseRecordFormat(format, record_format)) {
+        std::cout << "!ERROR" << std::endl;
+        std::cout << "Unknown record format: " << format
+                  << " (expected FIXED, SLOTTED or PAX)" << std::endl;
+        return false;
+    }
+    sm->setRecordFormat(record_format);
+    return true;
+}
+
 std::any SQLMyVisitor::visitShow_indexes(
     antlr4::SQLParser::Show_indexesContext* ctx) {
     throw NotImplementedError("SQLMyVisitor::visitShow_indexes");
@@ -625,7 +733,6 @@ std::any SQLMyVisitor::visitSelect_table(
 
     if (table_names.size() == 1) {
         std::vector<record::DataItem> result_datas;
-        std::vector<record::ColumnType> column_types;
         int table_id = sm->getTableId(table_names[0].c_str());
         if (table_id == -1) {
             std::cout << "!ERROR" << std::endl;
@@ -640,11 +747,31 @@ std::any SQLMyVisitor::visitSelect_table(
         }
         sm->fillInDataTypeField(constraints, table_id);
 
+        // Decode only the selected, ordering and constrained columns
+        record::TableSchemaPtr schema = sm->getTableSchema(table_id);
+        const std::vector<record::ColumnType>& table_column_types =
+            schema->columns;
+        record::ColumnMask column_mask;
+        bool projected = true;
+        for (auto& column_name : column_names) {
+            projected = maskColumn(table_column_types, std::get<1>(column_name),
+                                   column_mask) && projected;
+        }
+        if (order_by_column_name != "") {
+            projected = maskColumn(table_column_types, order_by_column_name,
+                                   column_mask) && projected;
+        }
+        for (auto& constraint : constraints) {
+            maskColumnId(column_mask, constraint.columnId);
+        }
+        if (!projected) column_mask.clear();
+
         std::vector<record::RecordLocation> record_locations;
-        if (! sm -> searchRowsInTable(table_id, constraints, result_datas, column_types,
-                        record_locations, -1)) {
+        if (! sm -> searchRowsInTable(table_id, constraints, result_datas, schema,
+                        record_locations, -1, column_mask)) {
             return false;
         }
+        const std::vector<record::ColumnType>& column_types = schema->columns;
 
         if (order_by_column_name != "") {
             int order_columnId = -1;
@@ -757,6 +884,28 @@ std::any SQLMyVisitor::visitSelect_table(
         table_id2path[table_id] = path;
     }
 
+    // Decode only the selected and join columns of each table
+    std::map<int, record::ColumnMask> table_id2column_mask;
+    for (int point_id = 0; point_id < total_table_num; point_id++) {
+        int table_id = point_id2table_id[point_id];
+        auto& column_mask = table_id2column_mask[table_id];
+        bool projected = true;
+        for (auto& column_name : column_names) {
+            if (std::get<0>(column_name) == table_names[point_id] ||
+                std::get<1>(column_name) == "*") {
+                projected = maskColumn(table_id2column_types[table_id],
+                                       std::get<1>(column_name), column_mask) &&
+                            projected;
+            }
+        }
+        for (auto& join_edge : join_edges[point_id]) {
+            for (int column_id : join_edge.start_pt_id) {
+                maskColumnId(column_mask, column_id);
+            }
+        }
+        if (!projected) column_mask.clear();
+    }
+
     std::map<int, bool> table_id2checked;
 
     std::vector<record::DataItem> result_datas;
@@ -811,7 +960,7 @@ std::any SQLMyVisitor::visitSelect_table(
                 std::vector<record::DataItem> upp_result_datas;
                 rm->getRecordsInPageRange(
                     table_id2path[select_table_id].c_str(), upp_result_datas,
-                    low_page, high_page);
+                    low_page, high_page, table_id2column_mask[select_table_id]);
                 for (auto& data_item : upp_result_datas) {
                     for (int i = 0; i < data_item.columnIds.size(); i++) {
                         data_item.columnIds[i] =
@@ -916,7 +1065,8 @@ std::any SQLMyVisitor::visitSelect_table(
                     std::vector<record::DataItem> select_result_datas;
                     rm->getRecordsInPageRange(
                         table_id2path[select_table_id].c_str(),
-                        select_result_datas, low_page, high_page);
+                        select_result_datas, low_page, high_page,
+                        table_id2column_mask[select_table_id]);
                     low_page += BLOCK_PAGE_NUM;
                     high_page =
                         std::min(high_page + BLOCK_PAGE_NUM, total_page + 1);
@@ -2184,20 +2334,20 @@ std::any SQLMyVisitor::visitSet_clause(
                 if (result.type() == typeid(std::string)) {
                     std::get<1>(assignment).dataType =
                         record::DataTypeIdentifier::VARCHAR;
-                    std::get<1>(assignment).value.charValue =
-                        std::any_cast<std::string>(result);
+                    std::get<1>(assignment).setChars(
+                        std::any_cast<std::string>(result));
                     std::get<1>(assignment).isNull = false;
                 } else if (result.type() == typeid(int)) {
                     std::get<1>(assignment).dataType =
                         record::DataTypeIdentifier::INT;
-                    std::get<1>(assignment).value.intValue =
-                        std::any_cast<int>(result);
+                    std::get<1>(assignment).setInt(
+                        std::any_cast<int>(result));
                     std::get<1>(assignment).isNull = false;
                 } else if (result.type() == typeid(double)) {
                     std::get<1>(assignment).dataType =
                         record::DataTypeIdentifier::FLOAT;
-                    std::get<1>(assignment).value.floatValue =
-                        std::any_cast<double>(result);
+                    std::get<1>(assignment).setFloat(
+                        std::any_cast<double>(result));
                     std::get<1>(assignment).isNull = false;
                 } else if (child->getText() == "NULL") {
                     // ! notice that NULL is of type ANY!
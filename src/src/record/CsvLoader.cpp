@@ -0,0 +1,207 @@
+#include "record/CsvLoader.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <charconv>
+#include <climits>
+#include <cstring>
+#include <string_view>
+
+namespace dbs {
+namespace record {
+
+namespace {
+
+const int RECORD_ID_BYTES = 4;
+const int VARCHAR_LENGTH_BYTES = 2;
+
+std::string_view trimSpaces(std::string_view text) {
+    while (!text.empty() && text.front() == ' ') text.remove_prefix(1);
+    while (!text.empty() && text.back() == ' ') text.remove_suffix(1);
+    return text;
+}
+
+// Whole field as one number; a leading '+' is accepted as std::stoi does
+template <typename T>
+bool parseNumber(std::string_view text, T& value) {
+    text = trimSpaces(text);
+    if (!text.empty() && text.front() == '+') text.remove_prefix(1);
+    const char* end = text.data() + text.size();
+    auto result = std::from_chars(text.data(), end, value);
+    return result.ec == std::errc() && result.ptr == end;
+}
+
+// YYYY-MM-DD, stored as the year in two bytes, then the month and day
+bool parseDate(std::string_view text, unsigned char* value) {
+    text = trimSpaces(text);
+    size_t first = text.find('-'), last = text.rfind('-');
+    if (first == std::string_view::npos || first == last) return false;
+    int year, month, day;
+    if (!parseNumber(text.substr(0, first), year) ||
+        !parseNumber(text.substr(first + 1, last - first - 1), month) ||
+        !parseNumber(text.substr(last + 1), day)) {
+        return false;
+    }
+    value[0] = year & 0xff;
+    value[1] = (year >> 8) & 0xff;
+    value[2] = month & 0xff;
+    value[3] = day & 0xff;
+    return true;
+}
+
+// An unquoted NULL, as DataValue::toString writes it
+bool isNullField(std::string_view field) { return trimSpaces(field) == "NULL"; }
+
+// Writes one field at `value`, or sets bit `column` of the record's null
+// bitmap for NULL; VARCHARs get their length prefix
+bool encodeField(std::string_view field, const ColumnType& column_type,
+                 unsigned char* record, int column, unsigned char* value) {
+    if (isNullField(field)) {
+        record[RECORD_ID_BYTES + column / 8] |= 1 << (column % 8);
+        return !column_type.isNotNull;
+    }
+    switch (column_type.dataType) {
+        case INT: {
+            int number;
+            if (!parseNumber(field, number)) return false;
+            memcpy(value, &number, sizeof(number));
+            return true;
+        }
+        case FLOAT: {
+            double number;
+            if (!parseNumber(field, number)) return false;
+            memcpy(value, &number, sizeof(number));
+            return true;
+        }
+        case VARCHAR:
+            if (field.size() > column_type.varcharSpace) return false;
+            value[0] = field.size() & 0xff;
+            value[1] = (field.size() >> 8) & 0xff;
+            memcpy(value + VARCHAR_LENGTH_BYTES, field.data(), field.size());
+            return true;
+        case DATE:
+            return parseDate(field, value);
+    }
+    return false;
+}
+
+// Bytes the field takes in a slotted tuple, which does not store NULLs
+int encodedWidth(std::string_view field, const ColumnType& column_type) {
+    if (isNullField(field)) return 0;
+    return column_type.dataType == VARCHAR ? VARCHAR_LENGTH_BYTES + field.size()
+                                           : getDataTypeSize(column_type.dataType);
+}
+
+}  // namespace
+
+CsvFile::~CsvFile() {
+    if (bytes != nullptr) munmap(bytes, length);
+}
+
+bool CsvFile::open(const char* path) {
+    int fd = ::open(path, O_RDONLY);
+    if (fd == -1) return false;
+    struct stat info;
+    if (fstat(fd, &info) == -1) {
+        close(fd);
+        return false;
+    }
+    length = info.st_size;
+    if (length > 0) {
+        void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            close(fd);
+            length = 0;
+            return false;
+        }
+        bytes = static_cast<char*>(mapped);
+        madvise(bytes, length, MADV_SEQUENTIAL);
+    }
+    close(fd);
+    return true;
+}
+
+std::vector<CsvChunk> splitCsvLines(const char* data, size_t size,
+                                    size_t chunk_bytes) {
+    std::vector<CsvChunk> chunks;
+    const char* end = data + size;
+    const char* begin = data;
+    while (begin < end) {
+        const char* split = begin + std::min(chunk_bytes, size_t(end - begin));
+        if (split < end) {
+            const char* newline =
+                static_cast<const char*>(memchr(split, '\n', end - split));
+            split = newline == nullptr ? end : newline + 1;
+        }
+        chunks.push_back(CsvChunk{begin, split});
+        begin = split;
+    }
+    return chunks;
+}
+
+bool encodeCsvRows(const CsvChunk& chunk, char delimiter,
+                   const std::vector<ColumnType>& column_types,
+                   const RowLayout& layout, const std::vector<int>& key_columns,
+                   EncodedRows& rows) {
+    int column_num = column_types.size();
+    bool slotted = layout.format == RecordFormat::SLOTTED;
+    int fixed_length = slotted || column_num == 0
+                           ? layout.values_offset
+                           : layout.column_offsets.back() + layout.column_widths.back();
+    std::vector<std::string_view> fields;
+    fields.reserve(column_num);
+    const char* line = chunk.begin;
+    while (line < chunk.end) {
+        const char* line_end =
+            static_cast<const char*>(memchr(line, '\n', chunk.end - line));
+        const char* next = line_end == nullptr ? chunk.end : line_end + 1;
+        if (line_end == nullptr) line_end = chunk.end;
+        if (line_end > line && line_end[-1] == '\r') line_end--;
+
+        fields.clear();
+        const char* field = line;
+        for (const char* p = line; p < line_end; p++) {
+            if (*p == delimiter) {
+                fields.emplace_back(field, p - field);
+                field = p + 1;
+            }
+        }
+        fields.emplace_back(field, line_end - field);
+        if (fields.size() != column_num) return false;
+
+        int start = rows.bytes.size();
+        int length = fixed_length;
+        if (slotted) {
+            for (int column = 0; column < column_num; column++) {
+                length += encodedWidth(fields[column], column_types[column]);
+            }
+        }
+        rows.offsets.push_back(start);
+        rows.bytes.resize(start + length, 0);
+        unsigned char* record = rows.bytes.data() + start;
+        int offset = layout.values_offset;
+        for (int column = 0; column < column_num; column++) {
+            if (!slotted) offset = layout.column_offsets[column];
+            if (!encodeField(fields[column], column_types[column], record, column,
+                             record + offset)) {
+                return false;
+            }
+            offset += encodedWidth(fields[column], column_types[column]);
+        }
+
+        RowView view(layout, record, 0);
+        for (int column : key_columns) {
+            rows.keys.push_back(layout.data_types[column] == INT && !view.isNull(column)
+                                    ? view.getInt(column)
+                                    : INT_MIN);
+        }
+        line = next;
+    }
+    return true;
+}
+
+}  // namespace record
+}  // namespace dbs
@@ -1,14 +1,30 @@
-#include <variant>
 #include <string>
 #include <iostream>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <new>
 
 #include "record/DataType.hpp"
 
 namespace dbs {
 namespace record {
 
+namespace {
+
+// Header of the buffer behind a long VARCHAR value; the characters follow it
+struct SharedChars {
+    std::atomic<uint32_t> refs;
+};
+
+SharedChars* sharedCharsOf(const char* data) {
+    return reinterpret_cast<SharedChars*>(const_cast<char*>(data) -
+                                          sizeof(SharedChars));
+}
+
+}  // namespace
+
 // Function to print the value of DataValue
 void DataValue::print() const {
     if (isNull) {
@@ -23,7 +39,7 @@ void DataValue::print() const {
                 std::cout << std::fixed << std::setprecision(2) << value.floatValue;
                 break;
             case DataTypeIdentifier::VARCHAR:
-                std::cout << value.charValue;
+                std::cout << chars();
                 break;
             case DataTypeIdentifier::DATE:
                 std::cout << value.dateValue.year << "-"
@@ -52,12 +68,12 @@ int getDataTypeSize(DataTypeIdentifier dataType) {
 }
 
 // DataValue constructors
-DataValue::DataValue() : isNull(true), dataType(DataTypeIdentifier::INT) {
+DataValue::DataValue() : dataType(DataTypeIdentifier::INT), isNull(true) {
     value.intValue = 0;
 }
 
 DataValue::DataValue(DataTypeIdentifier dataType_, bool isNull_)
-    : isNull(isNull_), dataType(dataType_){
+    : dataType(dataType_), isNull(isNull_){
     switch (dataType) {
         case DataTypeIdentifier::INT:
             value.intValue = 0;
@@ -65,9 +81,6 @@ DataValue::DataValue(DataTypeIdentifier dataType_, bool isNull_)
         case DataTypeIdentifier::FLOAT:
             value.floatValue = 0.0;
             break;
-        case DataTypeIdentifier::VARCHAR:
-            value.charValue = "";
-            break;
         case DataTypeIdentifier::DATE:
             value.dateValue = DateValue(0, 0, 0);
             break;
@@ -77,25 +90,69 @@ DataValue::DataValue(DataTypeIdentifier dataType_, bool isNull_)
 }
 
 DataValue::DataValue(DataTypeIdentifier dataType_, bool isNull_, int intValue_)
-    : isNull(isNull_), dataType(dataType_){
+    : dataType(dataType_), isNull(isNull_){
         value.intValue = intValue_; //  int
     }
 
 DataValue::DataValue(DataTypeIdentifier dataType_, bool isNull_, double floatValue_)
-    : isNull(isNull_), dataType(dataType_){
+    : dataType(dataType_), isNull(isNull_){
         value.floatValue = floatValue_; // float
     }
 
-DataValue::DataValue(DataTypeIdentifier dataType_, bool isNull_, const std::string & stringValue_)
-    : isNull(isNull_), dataType(dataType_){
-        value.charValue = stringValue_; // varchar
+DataValue::DataValue(DataTypeIdentifier dataType_, bool isNull_, std::string_view stringValue_)
+    : dataType(dataType_), isNull(isNull_){
+        setChars(stringValue_); // varchar
     }
 
 DataValue::DataValue(DataTypeIdentifier dataType_, bool isNull_, DateValue dateValue_)
-    : isNull(isNull_), dataType(dataType_){
+    : dataType(dataType_), isNull(isNull_){
         value.dateValue = dateValue_; // time
     }
 
+void DataValue::setInt(int intValue_) {
+    if (charStorage == LONG_CHARS) releaseChars();
+    value.intValue = intValue_;
+}
+
+void DataValue::setFloat(double floatValue_) {
+    if (charStorage == LONG_CHARS) releaseChars();
+    value.floatValue = floatValue_;
+}
+
+void DataValue::setDate(DateValue dateValue_) {
+    if (charStorage == LONG_CHARS) releaseChars();
+    value.dateValue = dateValue_;
+}
+
+void DataValue::setChars(std::string_view chars_) {
+    if (charStorage == LONG_CHARS) releaseChars();
+    if (chars_.size() <= SHORT_CHARS_CAPACITY) {
+        memcpy(value.shortChars, chars_.data(), chars_.size());
+        charStorage = chars_.size();
+        return;
+    }
+    char* buffer = static_cast<char*>(
+        ::operator new(sizeof(SharedChars) + chars_.size()));
+    new (buffer) SharedChars{{1}};
+    memcpy(buffer + sizeof(SharedChars), chars_.data(), chars_.size());
+    value.longChars.data = buffer + sizeof(SharedChars);
+    value.longChars.size = chars_.size();
+    charStorage = LONG_CHARS;
+}
+
+void DataValue::retainChars() const {
+    sharedCharsOf(value.longChars.data)->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void DataValue::releaseChars() {
+    SharedChars* shared = sharedCharsOf(value.longChars.data);
+    if (shared->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        shared->~SharedChars();
+        ::operator delete(shared);
+    }
+    charStorage = EMPTY_CHARS;
+}
+
 DefaultValue::DefaultValue() {
     hasDefaultValue = false;
 }
@@ -149,7 +206,7 @@ bool DataValue::isEqual(const DataValue& other) const {
                 if (value.floatValue != other.value.floatValue) return false;
                 break;
             case DataTypeIdentifier::VARCHAR:
-                if (value.charValue != other.value.charValue) return false;
+                if (chars() != other.chars()) return false;
                 break;
             case DataTypeIdentifier::DATE:
                 if (value.dateValue.year != other.value.dateValue.year) return false;
@@ -193,7 +250,7 @@ std::string DataValue::toString() const {
             case DataTypeIdentifier::FLOAT:
                 return std::to_string(value.floatValue);
             case DataTypeIdentifier::VARCHAR:
-                return value.charValue;
+                return std::string(chars());
             case DataTypeIdentifier::DATE:
                 return std::to_string(value.dateValue.year) + "-" +
                        std::to_string(value.dateValue.month) + "-" +
@@ -215,6 +272,21 @@ bool DefaultValue::isEqual(const DefaultValue& other) const{
     return true;
 }
 
+bool parseRecordFormat(const std::string& name, RecordFormat& format) {
+    std::string lower = name;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    if (lower == "fixed") {
+        format = RecordFormat::FIXED;
+    } else if (lower == "slotted") {
+        format = RecordFormat::SLOTTED;
+    } else if (lower == "pax") {
+        format = RecordFormat::PAX;
+    } else {
+        return false;
+    }
+    return true;
+}
+
 bool exactMatch(const std::vector<ColumnType>& columnTypes, const DataItem& dataItem){
     if (columnTypes.size() != dataItem.values.size()) {
         return false;
@@ -230,7 +302,7 @@ bool exactMatch(const std::vector<ColumnType>& columnTypes, const DataItem& data
         } else {
             switch (columnTypes[i].dataType) {
                 case DataTypeIdentifier::VARCHAR:
-                    if (dataItem.values[i].value.charValue.size() >
+                    if (dataItem.values[i].chars().size() >
                         (size_t)columnTypes[i].varcharLength) {
                         return false;
                     }
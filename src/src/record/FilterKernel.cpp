@@ -0,0 +1,259 @@
+#include "record/FilterKernel.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace dbs {
+namespace record {
+
+namespace {
+
+// A DATE key orders like DateValue: the year (unsigned, 16 bits) above the
+// month and day bytes, which DateValue reads as signed chars. Flipping the
+// top bit of each part turns that order into a signed 32-bit comparison.
+const unsigned int DATE_KEY_FLIP = 0x80008080U;
+
+int dateKey(unsigned int year, unsigned int month, unsigned int day) {
+    unsigned int key = year << 16 | (month & 0xff) << 8 | (day & 0xff);
+    return static_cast<int>(key ^ DATE_KEY_FLIP);
+}
+
+// Stored DATE: year in the low two bytes, then month, then day
+int storedDateKey(unsigned int word) {
+    return dateKey(word & 0xffff, word >> 16, word >> 24);
+}
+
+unsigned int loadWord(const unsigned char* p) {
+    unsigned int word;
+    memcpy(&word, p, sizeof(word));
+    return word;
+}
+
+// Where one column of every slot sits in a fixed or PAX page
+struct ColumnAccess {
+    const unsigned char* values;
+    int value_stride;
+    const unsigned char* nulls;  // null bitmap byte of the column in slot 0
+    int null_stride;
+    int null_bit;
+};
+
+ColumnAccess columnAccess(const RowLayout& layout, const unsigned char* data,
+                          int column) {
+    ColumnAccess access;
+    access.values = data + layout.column_offsets[column];
+    access.null_bit = column % 8;
+    if (layout.format == RecordFormat::PAX) {
+        access.value_stride = layout.column_widths[column];
+        access.nulls = data + layout.items_per_page * BYTE_PER_BUF + column / 8;
+        access.null_stride = layout.null_bytes;
+    } else {
+        access.value_stride = layout.slot_stride;
+        access.nulls = data + BYTE_PER_BUF + column / 8;
+        access.null_stride = layout.slot_stride;
+    }
+    return access;
+}
+
+// Bit k is set when slot first + k holds NULL
+unsigned int nullBits(const ColumnAccess& access, int first, int count) {
+    unsigned int bits = 0;
+    const unsigned char* p = access.nulls + first * access.null_stride;
+    for (int k = 0; k < count; k++, p += access.null_stride) {
+        bits |= static_cast<unsigned int>(*p >> access.null_bit & 1) << k;
+    }
+    return bits;
+}
+
+// Bit k of lt / eq is set when the value of slot first + k is below / equal
+// to the predicate's key
+void compareScalar(const ColumnAccess& access, const SlotPredicate& predicate,
+                   int first, int count, unsigned int& lt, unsigned int& eq) {
+    lt = eq = 0;
+    const unsigned char* p = access.values + first * access.value_stride;
+    for (int k = 0; k < count; k++, p += access.value_stride) {
+        bool below, equal;
+        if (predicate.dataType == FLOAT) {
+            double value;
+            memcpy(&value, p, sizeof(value));
+            below = value < predicate.floatKey;
+            equal = value == predicate.floatKey;
+        } else {
+            int value = predicate.dataType == DATE
+                            ? storedDateKey(loadWord(p))
+                            : static_cast<int>(loadWord(p));
+            below = value < predicate.intKey;
+            equal = value == predicate.intKey;
+        }
+        lt |= static_cast<unsigned int>(below) << k;
+        eq |= static_cast<unsigned int>(equal) << k;
+    }
+}
+
+#if defined(__x86_64__)
+bool cpuHasAvx2() {
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    return has_avx2;
+}
+
+// compareScalar over a full word of 32 slots. Values are loaded directly
+// when a PAX minipage holds them back to back, gathered otherwise.
+__attribute__((target("avx2"))) void compareAvx2(const ColumnAccess& access,
+                                                 const SlotPredicate& predicate,
+                                                 int first, unsigned int& lt,
+                                                 unsigned int& eq) {
+    lt = eq = 0;
+    int stride = access.value_stride;
+    const unsigned char* base = access.values + first * stride;
+    if (predicate.dataType == FLOAT) {
+        __m256d key = _mm256_set1_pd(predicate.floatKey);
+        __m128i index =
+            _mm_mullo_epi32(_mm_setr_epi32(0, 1, 2, 3), _mm_set1_epi32(stride));
+        for (int k = 0; k < BIT_PER_BUF; k += 4) {
+            const double* p = reinterpret_cast<const double*>(base + k * stride);
+            __m256d value = stride == sizeof(double)
+                                ? _mm256_loadu_pd(p)
+                                : _mm256_i32gather_pd(p, index, 1);
+            lt |= static_cast<unsigned int>(_mm256_movemask_pd(
+                      _mm256_cmp_pd(value, key, _CMP_LT_OQ)))
+                  << k;
+            eq |= static_cast<unsigned int>(_mm256_movemask_pd(
+                      _mm256_cmp_pd(value, key, _CMP_EQ_OQ)))
+                  << k;
+        }
+        return;
+    }
+    __m256i key = _mm256_set1_epi32(predicate.intKey);
+    __m256i index = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+                                       _mm256_set1_epi32(stride));
+    // Per 4-byte value: day, month, year low, year high (see storedDateKey)
+    __m256i date_order = _mm256_setr_epi8(3, 2, 0, 1, 7, 6, 4, 5, 11, 10, 8, 9,
+                                          15, 14, 12, 13, 3, 2, 0, 1, 7, 6, 4, 5,
+                                          11, 10, 8, 9, 15, 14, 12, 13);
+    __m256i date_flip = _mm256_set1_epi32(static_cast<int>(DATE_KEY_FLIP));
+    for (int k = 0; k < BIT_PER_BUF; k += 8) {
+        const unsigned char* p = base + k * stride;
+        __m256i value =
+            stride == BYTE_PER_BUF
+                ? _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p))
+                : _mm256_i32gather_epi32(reinterpret_cast<const int*>(p), index, 1);
+        if (predicate.dataType == DATE) {
+            value = _mm256_xor_si256(_mm256_shuffle_epi8(value, date_order),
+                                     date_flip);
+        }
+        lt |= static_cast<unsigned int>(_mm256_movemask_ps(
+                  _mm256_castsi256_ps(_mm256_cmpgt_epi32(key, value))))
+              << k;
+        eq |= static_cast<unsigned int>(_mm256_movemask_ps(
+                  _mm256_castsi256_ps(_mm256_cmpeq_epi32(value, key))))
+              << k;
+    }
+}
+#endif
+
+// Slots that pass, from the below / equal bits; written as in
+// validConstraintValue, where GT is !(<=) and GEQ is !(<)
+unsigned int passingBits(system::ConstraintType op, unsigned int lt,
+                         unsigned int eq) {
+    switch (op) {
+        case system::ConstraintType::EQ:
+            return eq;
+        case system::ConstraintType::NEQ:
+            return ~eq;
+        case system::ConstraintType::GT:
+            return ~(lt | eq);
+        case system::ConstraintType::GEQ:
+            return ~lt;
+        case system::ConstraintType::LT:
+            return lt;
+        case system::ConstraintType::LEQ:
+            return lt | eq;
+    }
+    return ~0U;
+}
+
+}  // namespace
+
+bool compileSlotPredicates(const system::SearchConstraint& constraint,
+                           const RowLayout& layout, int column,
+                           std::vector<SlotPredicate>& predicates) {
+    DataTypeIdentifier data_type = layout.data_types[column];
+    std::vector<SlotPredicate> compiled;
+    for (int j = 0; j < constraint.constraintTypes.size(); j++) {
+        auto op = constraint.constraintTypes[j];
+        auto& value = constraint.constraintValues[j];
+        SlotPredicate predicate{column, data_type, op, false, 0, 0.0};
+        if (value.isNull) {
+            // Only = NULL and <> NULL filter anything
+            if (op != system::ConstraintType::EQ &&
+                op != system::ConstraintType::NEQ) {
+                continue;
+            }
+            predicate.nullTest = true;
+            compiled.push_back(predicate);
+            continue;
+        }
+        if (value.dataType != data_type) return false;
+        switch (data_type) {
+            case INT:
+                predicate.intKey = value.value.intValue;
+                break;
+            case FLOAT:
+                predicate.floatKey = value.value.floatValue;
+                break;
+            case DATE: {
+                auto& date = value.value.dateValue;
+                if (date.year < 0 || date.year > 0xffff || date.month < -128 ||
+                    date.month > 127 || date.day < -128 || date.day > 127) {
+                    return false;
+                }
+                predicate.intKey = dateKey(date.year, date.month, date.day);
+                break;
+            }
+            default:
+                return false;
+        }
+        compiled.push_back(predicate);
+    }
+    predicates.insert(predicates.end(), compiled.begin(), compiled.end());
+    return true;
+}
+
+void filterSlots(const RowLayout& layout, const unsigned char* data,
+                 int slot_count, const SlotPredicate& predicate,
+                 unsigned int* selection) {
+    ColumnAccess access = columnAccess(layout, data, predicate.column);
+    for (int word = 0; word * BIT_PER_BUF < slot_count; word++) {
+        if (selection[word] == 0) continue;
+        int first = word * BIT_PER_BUF;
+        int count = std::min(BIT_PER_BUF, slot_count - first);
+        unsigned int nulls = nullBits(access, first, count);
+        if (predicate.nullTest) {
+            selection[word] &=
+                predicate.op == system::ConstraintType::EQ ? nulls : ~nulls;
+            continue;
+        }
+        unsigned int lt, eq;
+#if defined(__x86_64__)
+        if (count == BIT_PER_BUF && cpuHasAvx2()) {
+            compareAvx2(access, predicate, first, lt, eq);
+        } else {
+            compareScalar(access, predicate, first, count, lt, eq);
+        }
+#else
+        compareScalar(access, predicate, first, count, lt, eq);
+#endif
+        unsigned int pass = passingBits(predicate.op, lt, eq);
+        // A NULL value is unequal to everything and fails every other test
+        pass = predicate.op == system::ConstraintType::NEQ ? pass | nulls
+                                                           : pass & ~nulls;
+        selection[word] &= pass;
+    }
+}
+
+}  // namespace record
+}  // namespace dbs
@@ -1,122 +1,329 @@
 #include "record/RecordManager.hpp"
 
+#include <algorithm>
+#include <bit>
+
+#include "record/CsvLoader.hpp"
+#include "record/FilterKernel.hpp"
+
 namespace dbs {
 namespace record {
 
-RecordManager::RecordManager(fs::FileManager* fm_, fs::BufPageManager* bpm_) {
-    fm = fm_;
-    bpm = bpm_;
-    current_opening_file_paths.clear();
-    current_opening_file_ids.clear();
-    current_column_types_file_paths.clear();
-    current_column_types.clear();
+// A constraint paired with the index of the column it tests
+struct BoundConstraint {
+    const system::SearchConstraint* constraint;
+    int column;
+};
+
+// Constraints of a scan: those the filter kernel runs over raw page data,
+// and the rest, tested row by row through a RowView
+struct ScanFilter {
+    std::vector<SlotPredicate> predicates;
+    std::vector<BoundConstraint> residual;
+};
+
+namespace {
+
+bool hasPageSummary(const BufType b) {
+    return b[RECORD_PAGE_SUMMARY_BUF] == RECORD_PAGE_SUMMARY_MAGIC;
 }
 
-RecordManager::~RecordManager() {
-    cleanAllCurrentColumnTypes();
-    closeAllCurrentFile();
-    fm = nullptr;
-    bpm = nullptr;
+// Number of occupied slots, counted from the slot bitmap. No format has
+// more than SLOTTED_MAX_SLOTS slots; the header words after the bitmap hold
+// the slotted directory size and tuple area start
+int countLiveSlots(const BufType b) {
+    int live = 0;
+    for (int word = 0; word < SLOTTED_MAX_SLOTS / BIT_PER_BUF; word++) {
+        live += std::popcount(b[word]);
+    }
+    return live;
 }
 
-void RecordManager::closeAllCurrentFile() {
-    bpm->closeManager();
-    for (auto& file_path : current_opening_file_paths) {
-        delete[] file_path;
-        file_path = nullptr;
+void setPageSummary(BufType b, int live, bool full) {
+    b[RECORD_PAGE_SUMMARY_BUF] = RECORD_PAGE_SUMMARY_MAGIC;
+    b[RECORD_PAGE_SUMMARY_BUF + 1] = live;
+    b[RECORD_PAGE_SUMMARY_BUF + 2] =
+        (full ? RECORD_PAGE_FULL : 0) | (live == 0 ? RECORD_PAGE_EMPTY : 0);
+}
+
+// Calls visit(slotId) for every set bit of a slot bitmap below `limit`, in
+// slot order
+template <typename Visit>
+void forEachSelectedSlot(const unsigned int* bits, int limit, Visit&& visit) {
+    for (int word = 0; word * BIT_PER_BUF < limit; word++) {
+        for (unsigned int rest = bits[word]; rest != 0; rest &= rest - 1) {
+            int slot = word * BIT_PER_BUF + std::countr_zero(rest);
+            if (slot >= limit) return;
+            visit(slot);
+        }
     }
-    current_opening_file_paths.clear();
-    for (auto& file_id : current_opening_file_ids) {
-        fm->closeFile(file_id);
+}
+
+// Calls visit(slotId) for every occupied slot below `limit`, in slot order.
+// Empty pages cost one load and sparse pages one iteration per live row.
+template <typename Visit>
+void forEachLiveSlot(const BufType b, int limit, Visit&& visit) {
+    if (hasPageSummary(b) &&
+        (b[RECORD_PAGE_SUMMARY_BUF + 2] & RECORD_PAGE_EMPTY)) {
+        return;
     }
-    current_opening_file_ids.clear();
+    forEachSelectedSlot(b, limit, visit);
 }
 
-void RecordManager::closeFileIfExist(const char* file_path) {
-    int current_opening_file_num = current_opening_file_paths.size();
-    for (int i = 0; i < current_opening_file_num; i++) {
-        if (strcmp(current_opening_file_paths[i], file_path) == 0) {
-            int file_id = current_opening_file_ids[i];
-            bpm->closeManager();
-            fm->closeFile(file_id);
-            delete[] current_opening_file_paths[i];
-            current_opening_file_paths[i] = nullptr;
-            current_opening_file_paths.erase(
-                current_opening_file_paths.begin() + i);
-            current_opening_file_ids.erase(current_opening_file_ids.begin() +
-                                           i);
-            return;
+// First clear bit below `limit` of a slot bitmap, or -1 if all are set
+int firstClearBit(const BufType b, int limit) {
+    for (int word = 0; word * BIT_PER_BUF < limit; word++) {
+        unsigned int free_bits = ~b[word];
+        if (free_bits != 0) {
+            int slot = word * BIT_PER_BUF + std::countr_zero(free_bits);
+            return slot < limit ? slot : -1;
         }
     }
+    return -1;
 }
 
-void RecordManager::closeFirstFile() {
-    if (current_opening_file_ids.size() == 0) return;
-    bpm->closeManager();
-    int file_id = current_opening_file_ids.front();
-    current_opening_file_ids.erase(current_opening_file_ids.begin());
-    fm->closeFile(file_id);
-    delete[] current_opening_file_paths.front();
-    current_opening_file_paths.front() = nullptr;
-    current_opening_file_paths.erase(current_opening_file_paths.begin());
+// First free slot of a fixed-format page, or -1 if it is full
+int firstFreeSlot(const BufType b, int limit) {
+    if (hasPageSummary(b) &&
+        (b[RECORD_PAGE_SUMMARY_BUF + 2] & RECORD_PAGE_FULL)) {
+        return -1;
+    }
+    return firstClearBit(b, limit);
 }
 
-void RecordManager::cleanAllCurrentColumnTypes() {
-    for (auto& file_path : current_column_types_file_paths) {
-        delete[] file_path;
-        file_path = nullptr;
+/*
+ * Slotted pages: b[8] is the number of directory entries and b[9] the
+ * offset where the tuple area starts; tuples are packed at the end of the
+ * page and the directory grows after the header.
+ */
+const int SLOTTED_COUNT_BUF = 8;
+const int SLOTTED_HEAP_BUF = 9;
+const unsigned int SLOTTED_OFFSET_MASK = 0xffff;
+const unsigned int SLOTTED_LENGTH_MASK = 0x3fff;
+const int SLOTTED_FORWARD_LENGTH = 8;  // pageId, slotId
+
+unsigned char* pageBytes(BufType b) { return reinterpret_cast<unsigned char*>(b); }
+
+unsigned int& slotEntry(BufType b, int slot) {
+    return b[RECORD_PAGE_HEADER / BYTE_PER_BUF + slot];
+}
+
+int entryOffset(unsigned int entry) { return entry & SLOTTED_OFFSET_MASK; }
+
+int entryLength(unsigned int entry) { return (entry >> 16) & SLOTTED_LENGTH_MASK; }
+
+// Tuples are word aligned and can always be replaced by a forward pointer
+int allocationLength(int length) {
+    return std::max((length + BYTE_PER_BUF - 1) & ~(BYTE_PER_BUF - 1),
+                    SLOTTED_FORWARD_LENGTH);
+}
+
+void initSlottedPage(BufType b) {
+    memset(b, 0, RECORD_PAGE_HEADER);
+    b[SLOTTED_COUNT_BUF] = 0;
+    b[SLOTTED_HEAP_BUF] = PAGE_SIZE_BY_BYTE;
+}
+
+// Bytes left for tuples once deleted ones are compacted away
+int slottedFreeBytes(const BufType b) {
+    int count = b[SLOTTED_COUNT_BUF];
+    int used = RECORD_PAGE_HEADER + count * BYTE_PER_BUF;
+    for (int slot = 0; slot < count; slot++) {
+        if (utils::getBitFromBuffer(b, slot)) used += entryLength(slotEntry(b, slot));
+    }
+    return PAGE_SIZE_BY_BYTE - used;
+}
+
+// Moves the live tuples to the end of the page, leaving one free gap
+void compactSlottedPage(BufType b) {
+    unsigned char copy[PAGE_SIZE_BY_BYTE];
+    memcpy(copy, b, PAGE_SIZE_BY_BYTE);
+    int heap = PAGE_SIZE_BY_BYTE;
+    int count = b[SLOTTED_COUNT_BUF];
+    for (int slot = 0; slot < count; slot++) {
+        if (!utils::getBitFromBuffer(b, slot)) continue;
+        unsigned int& entry = slotEntry(b, slot);
+        int length = entryLength(entry);
+        heap -= length;
+        memcpy(pageBytes(b) + heap, copy + entryOffset(entry), length);
+        entry = (entry & ~SLOTTED_OFFSET_MASK) | heap;
+    }
+    b[SLOTTED_HEAP_BUF] = heap;
+}
+
+// Reserves `length` bytes for the (clear) slot `slot`
+bool allocateSlottedTupleAt(BufType b, int slot, int length) {
+    length = allocationLength(length);
+    int count = b[SLOTTED_COUNT_BUF];
+    int new_entries = std::max(slot + 1 - count, 0);
+    int needed = length + new_entries * BYTE_PER_BUF;
+    int gap = static_cast<int>(b[SLOTTED_HEAP_BUF]) - RECORD_PAGE_HEADER -
+              count * BYTE_PER_BUF;
+    if (gap < needed) {
+        if (slottedFreeBytes(b) < needed) return false;
+        compactSlottedPage(b);
     }
-    current_column_types_file_paths.clear();
-    current_column_types.clear();
+    for (; count <= slot; count++) slotEntry(b, count) = 0;
+    b[SLOTTED_COUNT_BUF] = count;
+    b[SLOTTED_HEAP_BUF] -= length;
+    slotEntry(b, slot) = b[SLOTTED_HEAP_BUF] | (length << 16);
+    utils::setBitInBuffer(b, slot, true);
+    return true;
+}
+
+// Reserves `length` bytes in the first free slot, or returns -1
+int allocateSlottedTuple(BufType b, int length) {
+    int slot = firstClearBit(b, SLOTTED_MAX_SLOTS);
+    if (slot == -1 || !allocateSlottedTupleAt(b, slot, length)) return -1;
+    return slot;
 }
 
-void RecordManager::cleanFirstColumnTypes() {
-    if (current_column_types_file_paths.size() == 0) return;
-    delete[] current_column_types_file_paths.front();
-    current_column_types_file_paths.erase(
-        current_column_types_file_paths.begin());
-    current_column_types.erase(current_column_types.begin());
+void writeSlottedTuple(BufType b, int slot, const unsigned char* tuple,
+                       int length, unsigned int flags) {
+    unsigned int& entry = slotEntry(b, slot);
+    memcpy(pageBytes(b) + entryOffset(entry), tuple, length);
+    entry |= flags;
 }
 
-void RecordManager::cleanColumnTypesIfExist(const char* file_path) {
-    int current_column_types_num = current_column_types_file_paths.size();
-    for (int i = 0; i < current_column_types_num; i++) {
-        if (strcmp(current_column_types_file_paths[i], file_path) == 0) {
-            delete[] current_column_types_file_paths[i];
-            current_column_types_file_paths[i] = nullptr;
-            current_column_types_file_paths.erase(
-                current_column_types_file_paths.begin() + i);
-            current_column_types.erase(current_column_types.begin() + i);
-            return;
+void freeSlottedTuple(BufType b, int slot) {
+    utils::setBitInBuffer(b, slot, false);
+    int count = b[SLOTTED_COUNT_BUF];
+    while (count > 0 && !utils::getBitFromBuffer(b, count - 1)) count--;
+    b[SLOTTED_COUNT_BUF] = count;
+}
+
+RecordLocation forwardTarget(BufType b, int slot) {
+    unsigned int target[2];
+    memcpy(target, pageBytes(b) + entryOffset(slotEntry(b, slot)), sizeof(target));
+    return RecordLocation{static_cast<int>(target[0]), static_cast<int>(target[1])};
+}
+
+bool slottedHasRoom(BufType b, int min_item_length) {
+    int slot = firstClearBit(b, SLOTTED_MAX_SLOTS);
+    if (slot == -1) return false;
+    int new_entries = std::max(slot + 1 - static_cast<int>(b[SLOTTED_COUNT_BUF]), 0);
+    return slottedFreeBytes(b) >=
+           allocationLength(min_item_length) + new_entries * BYTE_PER_BUF;
+}
+
+// Constraints on columns the table does not have are dropped, as
+// validConstraint ignores them
+std::vector<BoundConstraint> bindConstraints(
+    const std::vector<system::SearchConstraint>& constraints,
+    const std::vector<ColumnType>& column_types) {
+    std::vector<BoundConstraint> bound;
+    for (auto& constraint : constraints) {
+        for (int column = 0; column < column_types.size(); column++) {
+            if (column_types[column].columnId == constraint.columnId) {
+                bound.push_back(BoundConstraint{&constraint, column});
+            }
         }
     }
+    return bound;
 }
 
-int RecordManager::openFile(const char* file_path) {
-    int current_opening_file_num = current_opening_file_paths.size();
-    for (int i = 0; i < current_opening_file_num; i++) {
-        if (strcmp(current_opening_file_paths[i], file_path) == 0) {
-            return current_opening_file_ids[i];
+ScanFilter planScanFilter(const std::vector<system::SearchConstraint>& constraints,
+                          const std::vector<ColumnType>& column_types,
+                          const RowLayout& row_layout) {
+    ScanFilter filter;
+    for (auto& bound : bindConstraints(constraints, column_types)) {
+        // Slotted tuples have no fixed value offsets
+        if (row_layout.format == RecordFormat::SLOTTED ||
+            !compileSlotPredicates(*bound.constraint, row_layout, bound.column,
+                                   filter.predicates)) {
+            filter.residual.push_back(bound);
         }
     }
-    if (current_opening_file_num == cacheCapacity) {
-        closeFirstFile();
+    return filter;
+}
+
+// Fills `selection` with the occupied slots of a page that pass the
+// filter's kernel predicates
+void selectSlots(const BufType b, int slot_count, const RowLayout& row_layout,
+                 const ScanFilter& filter, unsigned int* selection) {
+    std::fill(selection, selection + SLOT_SELECTION_BUF, 0);
+    if (hasPageSummary(b) &&
+        (b[RECORD_PAGE_SUMMARY_BUF + 2] & RECORD_PAGE_EMPTY)) {
+        return;
+    }
+    std::copy(b, b + (slot_count + BIT_PER_BUF - 1) / BIT_PER_BUF, selection);
+    for (auto& predicate : filter.predicates) {
+        filterSlots(row_layout, pageBytes(b) + RECORD_PAGE_HEADER, slot_count,
+                    predicate, selection);
+    }
+}
+
+// Tests a row in place, decoding only the constrained columns
+bool matchesConstraints(const RowView& view,
+                        const std::vector<BoundConstraint>& bound,
+                        DataValue& scratch) {
+    for (auto& item : bound) {
+        view.getValue(item.column, scratch);
+        if (!system::validConstraintValue(*item.constraint, scratch)) {
+            return false;
+        }
     }
-    current_opening_file_paths.push_back(new char[strlen(file_path) + 1]);
-    strcpy(current_opening_file_paths.back(), file_path);
-    int file_id = fm->openFile(file_path);
-    current_opening_file_ids.push_back(file_id);
-    return file_id;
+    return true;
+}
+
+}  // namespace
+
+RecordManager::RecordManager(fs::FileManager* fm_, fs::BufPageManager* bpm_,
+                             fs::FileHandleCache* files_) {
+    fm = fm_;
+    bpm = bpm_;
+    owns_files = files_ == nullptr;
+    files = owns_files ? new fs::FileHandleCache(fm, bpm) : files_;
+    scan_workers = new utils::WorkerPool();
+}
+
+RecordManager::~RecordManager() {
+    invalidateAllSchemas();
+    closeAllCurrentFile();
+    if (owns_files) delete files;
+    files = nullptr;
+    delete scan_workers;
+    scan_workers = nullptr;
+    fm = nullptr;
+    bpm = nullptr;
+}
+
+void RecordManager::closeAllCurrentFile() { files->closeAll(); }
+
+void RecordManager::setScanThreads(int threads) {
+    delete scan_workers;
+    scan_workers = new utils::WorkerPool(threads);
+}
+
+void RecordManager::closeFileIfExist(const char* file_path) {
+    files->close(file_path);
+}
+
+void RecordManager::invalidateAllSchemas() { schemas.clear(); }
+
+void RecordManager::invalidateSchema(const char* file_path) {
+    schemas.erase(file_path);
+}
+
+int RecordManager::openFile(const char* file_path) {
+    return files->open(file_path);
 }
 
 void RecordManager::initializeRecordFile(
-    const char* file_path, const std::vector<ColumnType>& column_types) {
+    const char* file_path, const std::vector<ColumnType>& column_types,
+    RecordFormat format) {
     closeFileIfExist(file_path);
-    cleanColumnTypesIfExist(file_path);
+    invalidateSchema(file_path);
     if (fm->doesFileExist(file_path)) {
         assert(fm->deleteFile(file_path));
     }
     assert(fm->createFile(file_path));
+    std::string fsm_path = freeSpaceMapPath(file_path);
+    closeFileIfExist(fsm_path.c_str());
+    if (fm->doesFileExist(fsm_path.c_str())) {
+        assert(fm->deleteFile(fsm_path.c_str()));
+    }
+    resetFreeSpaceMap(openFreeSpaceMap(file_path), 0, false);
     int file_id = openFile(file_path);
     assert(file_id != -1);
     int index;
@@ -124,6 +331,11 @@ void RecordManager::initializeRecordFile(
     b = bpm->getPage(file_id, 0, index);
     for (int i = 0; i < RECORD_META_DATA_HEAD / BYTE_PER_BUF; i++) b[i] = 0;
     b[7] = (column_types.size() + BIT_PER_BUF - 1) / BIT_PER_BUF + 1;
+    if (format == RecordFormat::SLOTTED) {
+        utils::setBitInBuffer(b, RECORD_FORMAT_FLAG_BIT, true);
+    } else if (format == RecordFormat::PAX) {
+        utils::setBitInBuffer(b, RECORD_PAX_FLAG_BIT, true);
+    }
     for (auto& column : column_types) {
         utils::setBitInBuffer(b, b[4], true);
         unsigned int columnId = b[4]++;
@@ -164,7 +376,7 @@ void RecordManager::initializeRecordFile(
         utils::setBitInNumber(b[start_buf_position], 3, column.isUnique);
         if (column.defaultValue.hasDefaultValue && !defaultValue.isNull &&
             column.dataType == VARCHAR) {
-            defaultValue_varchar_len = defaultValue.value.charValue.size();
+            defaultValue_varchar_len = defaultValue.chars().size();
             utils::setTwoBytes(b[start_buf_position], 1,
                              defaultValue_varchar_len);
         }
@@ -188,7 +400,7 @@ void RecordManager::initializeRecordFile(
                             byte_position = 0;
                         }
                         utils::setByte(b[buf_position], byte_position++,
-                                        defaultValue.value.charValue[i]);
+                                        defaultValue.chars()[i]);
                     }
                     break;
                 case DATE:
@@ -207,7 +419,7 @@ void RecordManager::initializeRecordFile(
 
 void RecordManager::updateColumnUnique(const char* file_path, int columnId,
                                        bool unique) {
-    cleanAllCurrentColumnTypes();
+    invalidateSchema(file_path);
     int file_id = openFile(file_path);
     assert(file_id != -1);
     int index;
@@ -225,26 +437,26 @@ void RecordManager::updateColumnUnique(const char* file_path, int columnId,
 
 void RecordManager::getColumnTypes(const char* file_path,
                                    std::vector<ColumnType>& column_types) {
-    column_types.clear();
-    int current_column_types_num = current_column_types_file_paths.size();
-    for (int i = 0; i < current_column_types_num; i++) {
-        if (strcmp(current_column_types_file_paths[i], file_path) == 0) {
-            for (auto& column_type : current_column_types[i]) {
-                column_types.push_back(column_type);
-            }
-            return;
-        }
-    }
-    if (current_column_types_num == columnCacheCapacity) {
-        cleanFirstColumnTypes();
-    }
-    current_column_types_file_paths.push_back(new char[strlen(file_path) + 1]);
-    strcpy(current_column_types_file_paths.back(), file_path);
+    column_types = getSchema(file_path)->columns;
+}
+
+TableSchemaPtr RecordManager::getSchema(const char* file_path) {
+    auto cached = schemas.find(file_path);
+    if (cached != schemas.end()) return cached->second;
+    // Schemas already handed out stay alive with their holders
+    if (schemas.size() >= SCHEMA_CACHE_CAPACITY) schemas.clear();
+    TableSchemaPtr schema = loadSchema(file_path);
+    schemas.emplace(file_path, schema);
+    return schema;
+}
+
+TableSchemaPtr RecordManager::loadSchema(const char* file_path) {
+    std::vector<ColumnType> column_types;
     int file_id = openFile(file_path);
     assert(file_id != -1);
     int index;
     BufType b;
-    b = bpm->getPage(file_id, 0, index);
+    b = bpm->getPageReadOnly(file_id, 0, index);
     for (int i = 0; i < MAX_COLUMN_NUM; i++) {
         if (!utils::getBitFromBuffer(b, i)) continue;
         int start_buf_position =
@@ -286,54 +498,49 @@ void RecordManager::getColumnTypes(const char* file_path,
             start_buf_position++;
             switch (column_type.dataType) {
                 case INT:
-                    column_type.defaultValue.value.value.intValue =
-                        utils::bit32ToInt(b[start_buf_position]);
+                    column_type.defaultValue.value.setInt(
+                        utils::bit32ToInt(b[start_buf_position]));
                     break;
                 case FLOAT:
-                    column_type.defaultValue.value.value.floatValue =
+                    column_type.defaultValue.value.setFloat(
                         utils::bit32ToFloat(b[start_buf_position],
-                                           b[start_buf_position + 1]);
+                                           b[start_buf_position + 1]));
                     break;
-                case VARCHAR:
+                case VARCHAR: {
                     buf_position = start_buf_position, byte_position = 0;
-                    column_type.defaultValue.value.value.charValue = "";
+                    std::string chars;
                     for (int i = 0; i < defaultValue_varchar_len; i++) {
                         if (byte_position == BYTE_PER_BUF) {
                             buf_position++;
                             byte_position = 0;
                         }
-                        column_type.defaultValue.value.value.charValue
-                            .push_back(utils::getByte(b[buf_position],
+                        chars.push_back(utils::getByte(b[buf_position],
                                                        byte_position++));
                     }
+                    column_type.defaultValue.value.setChars(chars);
                     break;
+                }
                 case DATE:
-                    column_type.defaultValue.value.value.dateValue.year =
-                        utils::getTwoBytes(b[start_buf_position], 0);
-
-                    column_type.defaultValue.value.value.dateValue.month =
-                        utils::getByte(b[start_buf_position], 2);
-                    //
-                    column_type.defaultValue.value.value.dateValue.day =
-                        utils::getByte(b[start_buf_position], 3);
+                    column_type.defaultValue.value.setDate(DateValue(
+                        utils::getTwoBytes(b[start_buf_position], 0),
+                        utils::getByte(b[start_buf_position], 2),
+                        utils::getByte(b[start_buf_position], 3)));
                     break;
             }
         }
         column_types.push_back(column_type);
     }
+    RecordLayout layout = getLayout(b, column_types);
     bpm->accessPage(index);
-    current_column_types.push_back(std::vector<ColumnType>());
-    for (auto& column_type : column_types) {
-        current_column_types.back().push_back(column_type);
-    }
+    return std::make_shared<const TableSchema>(std::move(column_types), layout);
 }
 
-int RecordManager::insertRecordsToEmptyRecord(const char* file_path,
-                                              const char* csv_path,
-                                              const char* delimeter,
-                                              bool output) {
-    std::ifstream csv_file(csv_path);
-    if (!csv_file.is_open()) {
+int RecordManager::insertRecordsToEmptyRecord(
+    const char* file_path, const char* csv_path, const char* delimeter,
+    bool output, std::vector<RecordLocation>* record_locations,
+    const std::vector<int>& key_column_ids, std::vector<int>* keys) {
+    CsvFile csv_file;
+    if (!csv_file.open(csv_path)) {
         std::cerr << "Failed to open file " << csv_path << std::endl;
         return -1;
     }
@@ -341,105 +548,146 @@ int RecordManager::insertRecordsToEmptyRecord(const char* file_path,
     int file_id = openFile(file_path);
     assert(file_id != -1);
 
-    std::vector<ColumnType> column_types;
-    getColumnTypes(file_path, column_types);
-
+    TableSchemaPtr schema = getSchema(file_path);
+    const std::vector<ColumnType>& column_types = schema->columns;
+    const RecordLayout& layout = schema->layout;
+    int data_item_per_page = layout.data_item_per_page;
     BufType b;
     int index;
-    b = bpm->getPage(file_id, 0, index);
-    int null_bitmap_buf_size = b[7];
-    bpm->markPageDirty(index);
-    int data_item_length =
-        dataItemLength(column_types, null_bitmap_buf_size * BYTE_PER_BUF);
-    int data_item_per_page = std::min(
-        (PAGE_SIZE_BY_BYTE - RECORD_PAGE_HEADER) / data_item_length, MAX_ITEM_PER_PAGE);
-
-    int pageId = 1, slotId = 0, record_id = 0;
-    b = bpm->getPage(file_id, pageId, index);
-    memset(b, 0, BUF_PER_PAGE * BYTE_PER_BUF);
-    bpm->markPageDirty(index);
 
-    std::string line;
-    while (getline(csv_file, line)) {
-        std::vector<std::string> csv_row;
-        std::string item;
-        for (int i = 0; i < line.length(); i++) {
-            if (line[i] == delimeter[0]) {
-                csv_row.push_back(item);
-                item = "";
-            } else {
-                item += line[i];
+    // Parse the file in chunks of whole lines, one chunk per task; every row
+    // is encoded straight into its stored form
+    RowLayout encode_layout(column_types,
+                            layout.slotted ? RecordFormat::SLOTTED : RecordFormat::FIXED,
+                            layout.null_bitmap_buf_size, 0, 0);
+    std::vector<int> key_columns;
+    for (int column_id : key_column_ids) {
+        for (int column = 0; column < column_types.size(); column++) {
+            if (column_types[column].columnId == column_id) {
+                key_columns.push_back(column);
             }
         }
-        csv_row.push_back(item);
-
-        record::DataItem data_item;
-        int csv_row_idx = 0;
-        if (csv_row.size() != column_types.size()) {
+    }
+    std::vector<CsvChunk> chunks =
+        splitCsvLines(csv_file.data(), csv_file.size(), LOAD_CHUNK_BYTES);
+    int chunk_num = chunks.size();
+    std::vector<EncodedRows> encoded(chunk_num);
+    std::vector<char> parsed(chunk_num, 0);
+    scan_workers->run(chunk_num, [&](int chunk) {
+        parsed[chunk] = encodeCsvRows(chunks[chunk], delimeter[0], column_types,
+                                      encode_layout, key_columns, encoded[chunk]);
+    });
+    // first_row[c]: global index of the first row of chunk c
+    std::vector<int> first_row(chunk_num + 1, 0);
+    for (int chunk = 0; chunk < chunk_num; chunk++) {
+        if (!parsed[chunk]) {
             std::cout << "!ERROR" << std::endl;
             std::cout << "CSV file format error" << std::endl;
             return -1;
         }
-        for (auto& column : column_types) {
-            data_item.columnIds.push_back(column.columnId);
-            record::DateValue dateValue;
-            double floatValue;
-            if (column.dataType == record::DataTypeIdentifier::FLOAT) {
-                std::istringstream iss(csv_row[csv_row_idx++]);
-                iss >> floatValue;
+        first_row[chunk + 1] = first_row[chunk] + encoded[chunk].rowCount();
+    }
+    int record_num = first_row[chunk_num];
+
+    int page_num = 1;
+    if (layout.slotted) {
+        // Tuples are packed in row order, so page boundaries depend on the
+        // rows before; this part stays serial
+        fs::PageGuard pin(bpm, file_id, page_num);
+        b = pin.data();
+        memset(b, 0, BUF_PER_PAGE * BYTE_PER_BUF);
+        initSlottedPage(b);
+        pin.markDirty();
+        int record_id = 0;
+        for (auto& rows : encoded) {
+            for (int row = 0; row < rows.rowCount(); row++) {
+                unsigned char* tuple = rows.record(row);
+                int length = rows.recordLength(row);
+                unsigned int word = record_id++;
+                memcpy(tuple, &word, BYTE_PER_BUF);
+                int slotId = allocateSlottedTuple(b, length);
+                if (slotId == -1) {
+                    setPageSummary(b, countLiveSlots(b), true);
+                    pin = fs::PageGuard(bpm, file_id, ++page_num);
+                    b = pin.data();
+                    memset(b, 0, BUF_PER_PAGE * BYTE_PER_BUF);
+                    initSlottedPage(b);
+                    pin.markDirty();
+                    slotId = allocateSlottedTuple(b, length);
+                }
+                writeSlottedTuple(b, slotId, tuple, length, 0);
+                if (record_locations) record_locations->push_back({page_num, slotId});
             }
-            switch (column.dataType) {
-                case record::DataTypeIdentifier::INT:
-                    data_item.values.push_back(
-                        record::DataValue(record::DataTypeIdentifier::INT, false,
-                                          std::stoi(csv_row[csv_row_idx++])));
-                    break;
-                case record::DataTypeIdentifier::FLOAT:
-                    data_item.values.push_back(record::DataValue(
-                        record::DataTypeIdentifier::FLOAT, false, floatValue));
-                    break;
-                case record::DataTypeIdentifier::VARCHAR:
-                    data_item.values.push_back(
-                        record::DataValue(record::DataTypeIdentifier::VARCHAR, false,
-                                          csv_row[csv_row_idx++]));
-                    break;
-                case record::DataTypeIdentifier::DATE:
-                    dateValue.year = std::stoi(csv_row[csv_row_idx].substr(
-                        0, csv_row[csv_row_idx].find('-')));
-                    dateValue.month = std::stoi(csv_row[csv_row_idx].substr(
-                        csv_row[csv_row_idx].find('-') + 1,
-                        csv_row[csv_row_idx].rfind('-') -
-                            csv_row[csv_row_idx].find('-') - 1));
-                    dateValue.day = std::stoi(csv_row[csv_row_idx].substr(
-                        csv_row[csv_row_idx].rfind('-') + 1));
-                    csv_row_idx++;
-                    data_item.values.push_back(record::DataValue(
-                        record::DataTypeIdentifier::DATE, false, dateValue));
-                    break;
+        }
+    } else {
+        // Row r goes to slot r % data_item_per_page of page
+        // r / data_item_per_page + 1, so pages are filled independently
+        page_num = std::max(1, (record_num + data_item_per_page - 1) / data_item_per_page);
+        const RowLayout& page_layout = schema->row_layout;
+        int null_bytes = layout.null_bitmap_buf_size * BYTE_PER_BUF;
+        scan_workers->run(page_num, [&](int page) {
+            fs::PageGuard pin(bpm, file_id, page + 1);
+            BufType page_b = pin.data();
+            memset(page_b, 0, BUF_PER_PAGE * BYTE_PER_BUF);
+            unsigned char* data = pageBytes(page_b) + RECORD_PAGE_HEADER;
+            int first = page * data_item_per_page;
+            int count = std::min(data_item_per_page, record_num - first);
+            int chunk = std::upper_bound(first_row.begin(), first_row.end(), first) -
+                        first_row.begin() - 1;
+            for (int slotId = 0; slotId < count; slotId++) {
+                int record_id = first + slotId;
+                while (record_id >= first_row[chunk + 1]) chunk++;
+                EncodedRows& rows = encoded[chunk];
+                int row = record_id - first_row[chunk];
+                const unsigned char* record = rows.record(row);
+                unsigned int word = record_id;
+                if (!layout.pax) {
+                    unsigned char* slot = data + slotId * layout.data_item_length;
+                    memcpy(slot, record, rows.recordLength(row));
+                    memcpy(slot, &word, BYTE_PER_BUF);
+                } else {
+                    memcpy(data + slotId * BYTE_PER_BUF, &word, BYTE_PER_BUF);
+                    memcpy(data + data_item_per_page * BYTE_PER_BUF + slotId * null_bytes,
+                           record + BYTE_PER_BUF, null_bytes);
+                    for (int column = 0; column < column_types.size(); column++) {
+                        int width = page_layout.column_widths[column];
+                        memcpy(data + page_layout.column_offsets[column] + slotId * width,
+                               record + encode_layout.column_offsets[column], width);
+                    }
+                }
+                utils::setBitInBuffer(page_b, slotId, true);
+            }
+            setPageSummary(page_b, count, count == data_item_per_page);
+            pin.markDirty();
+        });
+        if (record_locations) {
+            record_locations->reserve(record_num);
+            for (int record_id = 0; record_id < record_num; record_id++) {
+                record_locations->push_back({record_id / data_item_per_page + 1,
+                                             record_id % data_item_per_page});
             }
         }
-
-        if (slotId == data_item_per_page) {
-            pageId++;
-            slotId = 0;
-            b = bpm->getPage(file_id, pageId, index);
-            memset(b, 0, BUF_PER_PAGE * BYTE_PER_BUF);
-            bpm->markPageDirty(index);
+    }
+    if (keys) {
+        for (auto& rows : encoded) {
+            keys->insert(keys->end(), rows.keys.begin(), rows.keys.end());
         }
-        setSlotItem(b, slotId, data_item_length, null_bitmap_buf_size,
-                    record_id++, data_item, column_types);
-        slotId++;
     }
-    csv_file.close();
     if (output) {
         std::cout << "rows" << std::endl;
-        std::cout << record_id << std::endl;
+        std::cout << record_num << std::endl;
     }
 
+    b = bpm->getPage(file_id, page_num, index);
+    bool last_page_free = pageHasRoom(b, layout);
+    setPageSummary(b, countLiveSlots(b), !last_page_free);
+    bpm->markPageDirty(index);
     b = bpm->getPage(file_id, 0, index);
-    b[5] = pageId;
-    b[6] = record_id;
+    b[5] = page_num;
+    b[6] = record_num;
     bpm->markPageDirty(index);
+    // Every page but the last one was filled up
+    resetFreeSpaceMap(openFreeSpaceMap(file_path), page_num, last_page_free);
     return data_item_per_page;
 }
 
@@ -448,50 +696,67 @@ RecordLocation RecordManager::insertRecord(const char* file_path,
     int file_id = openFile(file_path);
     assert(file_id != -1);
 
-    std::vector<ColumnType> column_types;
-    getColumnTypes(file_path, column_types);
+    TableSchemaPtr schema = getSchema(file_path);
+    const std::vector<ColumnType>& column_types = schema->columns;
     sortDataItem(column_types, data_item);
     if (!exactMatch(column_types, data_item)) {
         return RecordLocation{-1, -1};
     }
 
-    BufType b;
-    int index;
-    b = bpm->getPage(file_id, 0, index);
-    int page_num = b[5];
-    int record_id = b[6];
-    int null_bitmap_buf_size = b[7];
-    bpm->accessPage(index);
-    int data_item_length =
-        dataItemLength(column_types, null_bitmap_buf_size * BYTE_PER_BUF);
-    int data_item_per_page = std::min(
-        (PAGE_SIZE_BY_BYTE - RECORD_PAGE_HEADER) / data_item_length, MAX_ITEM_PER_PAGE);
-
-    for (int pageId = 1; pageId <= page_num; pageId++) {
-        b = bpm->getPage(file_id, pageId, index);
-        for (int slotId = 0; slotId < data_item_per_page; slotId++) {
-            if (!utils::getBitFromBuffer(b, slotId)) {
-                setSlotItem(b, slotId, data_item_length, null_bitmap_buf_size,
-                            record_id, data_item, column_types);
-                bpm->markPageDirty(index);
-                b = bpm->getPage(file_id, 0, index);
-                b[6]++;
-                bpm->markPageDirty(index);
-                return RecordLocation{pageId, slotId};
-            }
-            bpm->accessPage(index);
+    // 元数据页在整个插入过程中保持固定
+    fs::PageGuard meta(bpm, file_id, 0);
+    BufType meta_b = meta.data();
+    int page_num = meta_b[5];
+    int record_id = meta_b[6];
+    const RecordLayout& layout = schema->layout;
+    int data_item_per_page = layout.data_item_per_page;
+
+    int fsm_id = openFreeSpaceMap(file_path);
+    validateFreeSpaceMap(fsm_id, file_id, page_num, layout);
+    if (layout.slotted) {
+        std::vector<unsigned char> tuple;
+        encodeSlottedItem(record_id, data_item, column_types, tuple);
+        RecordLocation location =
+            placeSlottedTuple(file_id, fsm_id, meta_b, layout, tuple, 0);
+        meta_b[6]++;
+        meta.markDirty();
+        return location;
+    }
+    int pageId;
+    while ((pageId = findFreePage(fsm_id, page_num)) != -1) {
+        fs::PageGuard page(bpm, file_id, pageId);
+        BufType b = page.data();
+        int slotId = firstFreeSlot(b, data_item_per_page);
+        if (slotId == -1) {
+            setPageFree(fsm_id, pageId, false);  // stale bit
+            continue;
+        }
+        writeSlot(b, slotId, layout, record_id, data_item, column_types);
+        int live = countLiveSlots(b);
+        setPageSummary(b, live, live == data_item_per_page);
+        page.markDirty();
+        meta_b[6]++;
+        meta.markDirty();
+        if (live == data_item_per_page) {
+            setPageFree(fsm_id, pageId, false);
         }
+        return RecordLocation{pageId, slotId};
     }
-    b = bpm->getPage(file_id, page_num + 1, index);
+
+    // Every page is full: append one
+    pageId = page_num + 1;
+    fs::PageGuard page(bpm, file_id, pageId);
+    BufType b = page.data();
     for (int i = 0; i < RECORD_PAGE_HEADER / BYTE_PER_BUF; i++) b[i] = 0;
-    setSlotItem(b, 0, data_item_length, null_bitmap_buf_size, record_id,
-                data_item, column_types);
-    bpm->markPageDirty(index);
-    b = bpm->getPage(file_id, 0, index);
-    b[5]++;
-    b[6]++;
-    bpm->markPageDirty(index);
-    return RecordLocation{page_num + 1, 0};
+    writeSlot(b, 0, layout, record_id, data_item, column_types);
+    setPageSummary(b, 1, data_item_per_page == 1);
+    page.markDirty();
+    meta_b[5]++;
+    meta_b[6]++;
+    meta.markDirty();
+
+    appendFreeSpaceMapPage(fsm_id, pageId, data_item_per_page > 1);
+    return RecordLocation{pageId, 0};
 }
 
 bool RecordManager::deleteRecord(const char* file_path,
@@ -500,9 +765,30 @@ bool RecordManager::deleteRecord(const char* file_path,
     assert(file_id != -1);
     int index;
     BufType b;
+    TableSchemaPtr schema = getSchema(file_path);
+    const RecordLayout& layout = schema->layout;
+    int fsm_id = openFreeSpaceMap(file_path);
+    if (layout.slotted) {
+        fs::PageGuard page(bpm, file_id, record_location.pageId);
+        b = page.data();
+        if (!utils::getBitFromBuffer(b, record_location.slotId)) return false;
+        unsigned int entry = slotEntry(b, record_location.slotId);
+        RecordLocation moved = (entry & SLOTTED_FORWARD)
+                                   ? forwardTarget(b, record_location.slotId)
+                                   : RecordLocation{-1, -1};
+        freeSlottedTuple(b, record_location.slotId);
+        bool room = slottedHasRoom(b, layout.min_item_length);
+        setPageSummary(b, countLiveSlots(b), !room);
+        page.markDirty();
+        if (room) setPageFree(fsm_id, record_location.pageId, true);
+        if (moved.pageId != -1) releaseSlottedTuple(file_id, fsm_id, layout, moved);
+        return true;
+    }
     b = bpm->getPage(file_id, record_location.pageId, index);
     utils::setBitInBuffer(b, record_location.slotId, false);
+    setPageSummary(b, countLiveSlots(b), false);
     bpm->markPageDirty(index);
+    setPageFree(fsm_id, record_location.pageId, true);
     return true;
 }
 
@@ -511,23 +797,16 @@ bool RecordManager::getRecord(const char* file_path,
                               DataItem& data_item) {
     int file_id = openFile(file_path);
     assert(file_id != -1);
-    std::vector<ColumnType> column_types;
-    getColumnTypes(file_path, column_types);
-    int index;
+    TableSchemaPtr schema = getSchema(file_path);
+    const RecordLayout& layout = schema->layout;
+    const RowLayout& row_layout = schema->row_layout;
     BufType b;
-    b = bpm->getPage(file_id, 0, index);
-    int null_bitmap_buf_size = b[7];
-
-    bpm->accessPage(index);
 
-    b = bpm->getPage(file_id, record_location.pageId, index);
-    bpm->accessPage(index);
+    fs::PageGuard pin;
+    b = scanPage(file_id, record_location.pageId, layout, pin);
     if (!utils::getBitFromBuffer(b, record_location.slotId)) return false;
-    data_item = getSlotItem(
-        b, record_location.slotId,
-        dataItemLength(column_types, null_bitmap_buf_size * BYTE_PER_BUF),
-        null_bitmap_buf_size, column_types);
-    return true;
+    return readSlot(file_id, b, record_location.slotId, layout, row_layout,
+                    data_item);
 }
 
 bool RecordManager::getRecords(
@@ -536,23 +815,22 @@ bool RecordManager::getRecords(
     data_items.clear();
     int file_id = openFile(file_path);
     assert(file_id != -1);
-    int index;
     BufType b;
 
-    b = bpm->getPage(file_id, 0, index);
-    int null_bitmap_buf_size = b[7];
-
-    std::vector<ColumnType> column_types;
-    getColumnTypes(file_path, column_types);
+    TableSchemaPtr schema = getSchema(file_path);
+    const RecordLayout& layout = schema->layout;
+    const RowLayout& row_layout = schema->row_layout;
 
+    DataItem data_item;
     for (auto& record_location : record_locations) {
-        b = bpm->getPage(file_id, record_location.pageId, index);
-        bpm->accessPage(index);
-        if (!utils::getBitFromBuffer(b, record_location.slotId)) return false;
-        data_items.push_back(getSlotItem(
-            b, record_location.slotId,
-            dataItemLength(column_types, null_bitmap_buf_size * BYTE_PER_BUF),
-            null_bitmap_buf_size, column_types));
+        fs::PageGuard pin;
+        b = scanPage(file_id, record_location.pageId, layout, pin);
+        if (!utils::getBitFromBuffer(b, record_location.slotId) ||
+            !readSlot(file_id, b, record_location.slotId, layout, row_layout,
+                      data_item)) {
+            return false;
+        }
+        data_items.push_back(std::move(data_item));
     }
     return true;
 }
@@ -579,40 +857,95 @@ bool RecordManager::updateRecord(const char* file_path,
             return false;
         }
     }
+    if (isSlottedFile(file_path)) {
+        return updateSlottedRecord(file_path, record_location, original_data_item);
+    }
     if (!deleteRecord(file_path, record_location)) {
         return false;
     }
     int file_id = openFile(file_path);
     assert(file_id != -1);
-    std::vector<ColumnType> column_types;
-    getColumnTypes(file_path, column_types);
+    TableSchemaPtr schema = getSchema(file_path);
+    const std::vector<ColumnType>& column_types = schema->columns;
+    const RecordLayout& layout = schema->layout;
+    int data_item_per_page = layout.data_item_per_page;
 
     BufType b;
     int index;
-    b = bpm->getPage(file_id, 0, index);
-    int null_bitmap_buf_size = b[7];
-    bpm->accessPage(index);
-    int data_item_length =
-        dataItemLength(column_types, null_bitmap_buf_size * BYTE_PER_BUF);
-
     b = bpm->getPage(file_id, record_location.pageId, index);
 
     sortDataItem(column_types, original_data_item);
     if (!exactMatch(column_types, original_data_item)) {
-        setSlotItem(b, record_location.slotId, data_item_length,
-                    null_bitmap_buf_size, original_data_item.dataId,
-                    original_data_item_save, column_types);
+        writeSlot(b, record_location.slotId, layout, original_data_item.dataId,
+                  original_data_item_save, column_types);
+        int live = countLiveSlots(b);
+        setPageSummary(b, live, live == data_item_per_page);
         bpm->markPageDirty(index);
         return false;
     }
 
-    setSlotItem(b, record_location.slotId, data_item_length,
-                null_bitmap_buf_size, original_data_item.dataId,
-                original_data_item, column_types);
+    writeSlot(b, record_location.slotId, layout, original_data_item.dataId,
+              original_data_item, column_types);
+    int live = countLiveSlots(b);
+    setPageSummary(b, live, live == data_item_per_page);
     bpm->markPageDirty(index);
     return true;
 }
 
+bool RecordManager::isSlottedFile(const char* file_path) {
+    return getSchema(file_path)->layout.slotted;
+}
+
+bool RecordManager::updateSlottedRecord(const char* file_path,
+                                        const RecordLocation& record_location,
+                                        DataItem data_item) {
+    int file_id = openFile(file_path);
+    assert(file_id != -1);
+    TableSchemaPtr schema = getSchema(file_path);
+    const std::vector<ColumnType>& column_types = schema->columns;
+    sortDataItem(column_types, data_item);
+    if (!exactMatch(column_types, data_item)) {
+        return false;
+    }
+
+    fs::PageGuard meta(bpm, file_id, 0);
+    BufType meta_b = meta.data();
+    const RecordLayout& layout = schema->layout;
+    int fsm_id = openFreeSpaceMap(file_path);
+    validateFreeSpaceMap(fsm_id, file_id, meta_b[5], layout);
+    std::vector<unsigned char> tuple;
+    encodeSlottedItem(data_item.dataId, data_item, column_types, tuple);
+
+    fs::PageGuard page(bpm, file_id, record_location.pageId);
+    BufType b = page.data();
+    page.markDirty();
+    int slotId = record_location.slotId;
+    if (slotEntry(b, slotId) & SLOTTED_FORWARD) {
+        releaseSlottedTuple(file_id, fsm_id, layout, forwardTarget(b, slotId));
+    }
+    // The slot keeps its id (indexes point at it); the tuple moves to
+    // another page only if it no longer fits in this one
+    freeSlottedTuple(b, slotId);
+    if (allocateSlottedTupleAt(b, slotId, tuple.size())) {
+        writeSlottedTuple(b, slotId, tuple.data(), tuple.size(), 0);
+    } else {
+        // Reserve the forward pointer first: the old tuple was at least as big
+        bool placed = allocateSlottedTupleAt(b, slotId, SLOTTED_FORWARD_LENGTH);
+        assert(placed);
+        RecordLocation target = placeSlottedTuple(file_id, fsm_id, meta_b, layout,
+                                                  tuple, SLOTTED_MOVED_IN);
+        meta.markDirty();
+        unsigned int pointer[2] = {static_cast<unsigned int>(target.pageId),
+                                   static_cast<unsigned int>(target.slotId)};
+        writeSlottedTuple(b, slotId, reinterpret_cast<unsigned char*>(pointer),
+                          sizeof(pointer), SLOTTED_FORWARD);
+    }
+    bool room = slottedHasRoom(b, layout.min_item_length);
+    setPageSummary(b, countLiveSlots(b), !room);
+    setPageFree(fsm_id, record_location.pageId, room);
+    return true;
+}
+
 void RecordManager::setSlotItem(BufType b, int slotId, int slot_length,
                                 int null_bitmap_buf_size, int record_id,
                                 const DataItem& data_item,
@@ -658,7 +991,7 @@ void RecordManager::setSlotItem(BufType b, int slotId, int slot_length,
                                        b[start_buf_position + 1]);
                     break;
                 case VARCHAR:
-                    varcharLength = data_value.value.charValue.size();
+                    varcharLength = data_value.chars().size();
                     utils::setTwoBytes(b[start_buf_position], 0, varcharLength);
                     buf_position = start_buf_position, buf_offset = 2;
                     for (int i = 0; i < varcharLength; i++) {
@@ -667,7 +1000,7 @@ void RecordManager::setSlotItem(BufType b, int slotId, int slot_length,
                             buf_offset = 0;
                         }
                         utils::setByte(b[buf_position], buf_offset++,
-                                        data_value.value.charValue[i]);
+                                        data_value.chars()[i]);
                     }
                     break;
                 case DATE:
@@ -684,81 +1017,6 @@ void RecordManager::setSlotItem(BufType b, int slotId, int slot_length,
     }
 }
 
-DataItem RecordManager::getSlotItem(
-    BufType b, int slotId, int slot_length, int null_bitmap_buf_size,
-    const std::vector<ColumnType>& column_types) {
-    DataItem data_item;
-    int start_buf_position =
-        (RECORD_PAGE_HEADER + slotId * slot_length) / BYTE_PER_BUF;
-    data_item.dataId = b[start_buf_position];
-    int column_num = column_types.size(), buf_position = start_buf_position;
-    int buf_offset = 0;
-    start_buf_position++;
-    for (int columnId = 0; columnId < column_num; columnId++) {
-        if (columnId % BIT_PER_BUF == 0) buf_position++;
-        bool isNull =
-            utils::getBitFromNumber(b[buf_position], columnId & BIT_PER_BUF_MASK);
-        data_item.values.push_back(
-            DataValue{column_types[columnId].dataType, isNull});
-        data_item.columnIds.push_back(column_types[columnId].columnId);
-    }
-    start_buf_position += null_bitmap_buf_size;
-    for (int columnId = 0; columnId < column_num; columnId++) {
-        auto& column_type = column_types[columnId];
-        int column_byte_width = 0;
-        data_item.values[columnId].dataType = column_type.dataType;
-        switch (column_type.dataType) {
-            case INT:
-            case FLOAT:
-            case DATE:
-                column_byte_width = getDataTypeSize(column_type.dataType);
-                break;
-            case VARCHAR:
-                column_byte_width = column_type.varcharSpace + 2;
-                break;
-        }
-        if (!data_item.values[columnId].isNull) {
-            int varcharLength = 0;
-            switch (column_type.dataType) {
-                case INT:
-                    data_item.values[columnId].value.intValue =
-                        utils::bit32ToInt(b[start_buf_position]);
-                    break;
-                case FLOAT:
-                    data_item.values[columnId].value.floatValue =
-                        utils::bit32ToFloat(b[start_buf_position],
-                                           b[start_buf_position + 1]);
-                    break;
-                case VARCHAR:
-                    varcharLength = utils::getTwoBytes(b[start_buf_position], 0);
-                    data_item.values[columnId].value.charValue = "";
-                    buf_position = start_buf_position, buf_offset = 2;
-                    for (int i = 0; i < varcharLength; i++) {
-                        if (buf_offset == BYTE_PER_BUF) {
-                            buf_position++;
-                            buf_offset = 0;
-                        }
-                        data_item.values[columnId]
-                            .value.charValue.push_back(
-                                utils::getByte(b[buf_position], buf_offset++));
-                    }
-                    break;
-                case DATE:
-                    data_item.values[columnId].value.dateValue.year =
-                        utils::getTwoBytes(b[start_buf_position], 0);
-
-                    data_item.values[columnId].value.dateValue.month =
-                        utils::getByte(b[start_buf_position], 2);
-                    data_item.values[columnId].value.dateValue.day =
-                        utils::getByte(b[start_buf_position], 3);
-                    break;
-            }
-        }
-        start_buf_position += column_byte_width / BYTE_PER_BUF;
-    }
-    return data_item;
-}
-
 int RecordManager::dataItemLength(const std::vector<ColumnType>& column_types,
                                   int null_bitmap_size) {
     // return byte length
@@ -784,11 +1042,376 @@ int RecordManager::dataItemLength(const std::vector<ColumnType>& column_types,
 
 bool RecordManager::deleteRecordFile(const char* file_path) {
     closeFileIfExist(file_path);
-    cleanColumnTypesIfExist(file_path);
+    invalidateSchema(file_path);
+    std::string fsm_path = freeSpaceMapPath(file_path);
+    closeFileIfExist(fsm_path.c_str());
+    if (fm->doesFileExist(fsm_path.c_str())) fm->deleteFile(fsm_path.c_str());
     if (!fm->doesFileExist(file_path)) return false;
     return fm->deleteFile(file_path);
 }
 
+std::string RecordManager::freeSpaceMapPath(const char* file_path) const {
+    return std::string(file_path) + FREE_SPACE_MAP_SUFFIX;
+}
+
+int RecordManager::openFreeSpaceMap(const char* file_path) {
+    std::string fsm_path = freeSpaceMapPath(file_path);
+    int fsm_id = files->find(fsm_path.c_str());
+    if (fsm_id != -1) return fsm_id;
+    if (!fm->doesFileExist(fsm_path.c_str())) {
+        // magic stays 0 until validateFreeSpaceMap builds it
+        assert(fm->createFile(fsm_path.c_str()));
+    }
+    fsm_id = openFile(fsm_path.c_str());
+    assert(fsm_id != -1);
+    return fsm_id;
+}
+
+void RecordManager::validateFreeSpaceMap(int fsm_id, int file_id, int page_num,
+                                         const RecordLayout& layout) {
+    int index;
+    BufType header = bpm->getPage(fsm_id, 0, index);
+    bpm->accessPage(index);
+    if (header[0] == FREE_SPACE_MAP_MAGIC &&
+        static_cast<int>(header[2]) == page_num) {
+        return;
+    }
+    resetFreeSpaceMap(fsm_id, page_num, false);
+    for (int pageId = 1; pageId <= page_num; pageId++) {
+        BufType b = bpm->getPageReadOnly(file_id, pageId, index);
+        bool free = pageHasRoom(b, layout);
+        bpm->accessPage(index);
+        if (free) setPageFree(fsm_id, pageId, true);
+    }
+}
+
+void RecordManager::resetFreeSpaceMap(int fsm_id, int page_num,
+                                      bool last_page_free) {
+    int index;
+    int map_pages = std::max((page_num + BIT_PER_PAGE - 1) / BIT_PER_PAGE, 1);
+    for (int mapPage = 1; mapPage <= map_pages; mapPage++) {
+        BufType map = bpm->getPage(fsm_id, mapPage, index);
+        memset(map, 0, PAGE_SIZE_BY_BYTE);
+        bpm->markPageDirty(index);
+    }
+    BufType header = bpm->getPage(fsm_id, 0, index);
+    memset(header, 0, PAGE_SIZE_BY_BYTE);
+    header[0] = FREE_SPACE_MAP_MAGIC;
+    header[1] = page_num + 1;
+    header[2] = page_num;
+    bpm->markPageDirty(index);
+    if (last_page_free && page_num > 0) setPageFree(fsm_id, page_num, true);
+}
+
+int RecordManager::findFreePage(int fsm_id, int page_num) {
+    int index;
+    BufType header = bpm->getPage(fsm_id, 0, index);
+    bpm->accessPage(index);
+    int cursor = std::max(static_cast<int>(header[1]), 1);
+    int found = -1;
+    for (int pageId = cursor; pageId <= page_num && found == -1;) {
+        int bit = pageId - 1;
+        int mapPage = bit / BIT_PER_PAGE + 1;
+        int first = bit % BIT_PER_PAGE;
+        int last = std::min(page_num - 1 - (mapPage - 1) * BIT_PER_PAGE,
+                            BIT_PER_PAGE - 1);
+        BufType map = bpm->getPage(fsm_id, mapPage, index);
+        bpm->accessPage(index);
+        for (int word = first / BIT_PER_BUF; word <= last / BIT_PER_BUF; word++) {
+            unsigned int bits = map[word];
+            if (word == first / BIT_PER_BUF) bits &= ~0U << (first & BIT_PER_BUF_MASK);
+            if (bits == 0) continue;
+            int position = word * BIT_PER_BUF + std::countr_zero(bits);
+            if (position <= last) {
+                found = (mapPage - 1) * BIT_PER_PAGE + position + 1;
+            }
+            break;
+        }
+        pageId = mapPage * BIT_PER_PAGE + 1;
+    }
+    // Pages below the free one (or all pages) are full
+    int new_cursor = found == -1 ? page_num + 1 : found;
+    if (new_cursor != cursor) {
+        header = bpm->getPage(fsm_id, 0, index);
+        header[1] = new_cursor;
+        bpm->markPageDirty(index);
+    }
+    return found;
+}
+
+void RecordManager::setPageFree(int fsm_id, int page_id, bool free) {
+    int index;
+    int bit = page_id - 1;
+    BufType map = bpm->getPage(fsm_id, bit / BIT_PER_PAGE + 1, index);
+    if (utils::getBitFromBuffer(map, bit % BIT_PER_PAGE) != free) {
+        utils::setBitInBuffer(map, bit % BIT_PER_PAGE, free);
+        bpm->markPageDirty(index);
+    } else {
+        bpm->accessPage(index);
+    }
+    if (free) {
+        BufType header = bpm->getPage(fsm_id, 0, index);
+        if (static_cast<int>(header[1]) > page_id) {
+            header[1] = page_id;
+            bpm->markPageDirty(index);
+        }
+    }
+}
+
+RecordLayout RecordManager::getLayout(
+    const BufType meta, const std::vector<ColumnType>& column_types) {
+    RecordLayout layout;
+    layout.slotted = utils::getBitFromBuffer(meta, RECORD_FORMAT_FLAG_BIT);
+    layout.pax = utils::getBitFromBuffer(meta, RECORD_PAX_FLAG_BIT);
+    layout.null_bitmap_buf_size = meta[7];
+    if (layout.slotted) {
+        int column_num = column_types.size();
+        layout.min_item_length = 4 + (column_num + 7) / 8;
+        layout.data_item_length = layout.min_item_length;
+        for (auto& column_type : column_types) {
+            layout.data_item_length +=
+                column_type.dataType == VARCHAR
+                    ? 2 + column_type.varcharLength
+                    : getDataTypeSize(column_type.dataType);
+        }
+        layout.data_item_per_page = SLOTTED_MAX_SLOTS;
+    } else {
+        layout.data_item_length = dataItemLength(
+            column_types, layout.null_bitmap_buf_size * BYTE_PER_BUF);
+        layout.data_item_per_page =
+            std::min((PAGE_SIZE_BY_BYTE - RECORD_PAGE_HEADER) / layout.data_item_length,
+                     MAX_ITEM_PER_PAGE);
+        layout.min_item_length = layout.data_item_length;
+    }
+    return layout;
+}
+
+void RecordManager::writeSlot(BufType b, int slot_id, const RecordLayout& layout,
+                              int record_id, const DataItem& data_item,
+                              const std::vector<ColumnType>& column_types) {
+    if (layout.pax) {
+        setPaxItem(b, slot_id, layout, record_id, data_item, column_types);
+    } else {
+        setSlotItem(b, slot_id, layout.data_item_length,
+                    layout.null_bitmap_buf_size, record_id, data_item,
+                    column_types);
+    }
+}
+
+void RecordManager::setPaxItem(BufType b, int slot_id, const RecordLayout& layout,
+                               int record_id, const DataItem& data_item,
+                               const std::vector<ColumnType>& column_types) {
+    utils::setBitInBuffer(b, slot_id, true);
+    int slots = layout.data_item_per_page;
+    int null_bytes = layout.null_bitmap_buf_size * BYTE_PER_BUF;
+    unsigned char* data = pageBytes(b) + RECORD_PAGE_HEADER;
+    unsigned int word = record_id;
+    memcpy(data + slot_id * BYTE_PER_BUF, &word, BYTE_PER_BUF);
+    unsigned char* null_bitmap = data + slots * BYTE_PER_BUF + slot_id * null_bytes;
+    memset(null_bitmap, 0, null_bytes);
+    // Bytes of a fixed-format record before the column; its minipage holds
+    // one value for each slot of the page
+    int offset = BYTE_PER_BUF + null_bytes;
+    int column_num = column_types.size();
+    for (int columnId = 0; columnId < column_num; columnId++) {
+        auto& data_value = data_item.values[columnId];
+        auto& column_type = column_types[columnId];
+        int width = column_type.dataType == VARCHAR
+                        ? column_type.varcharSpace + 2
+                        : getDataTypeSize(column_type.dataType);
+        unsigned char* value = data + offset * slots + slot_id * width;
+        offset += width;
+        if (data_value.isNull) {
+            null_bitmap[columnId / 8] |= 1 << (columnId % 8);
+            continue;
+        }
+        unsigned int words[2];
+        int length;
+        switch (column_type.dataType) {
+            case INT:
+                words[0] = utils::intToBit32(data_value.value.intValue);
+                memcpy(value, words, BYTE_PER_BUF);
+                break;
+            case FLOAT:
+                utils::floatToBit32(data_value.value.floatValue, words[0], words[1]);
+                memcpy(value, words, sizeof(words));
+                break;
+            case VARCHAR:
+                length = data_value.chars().size();
+                value[0] = length & 0xff;
+                value[1] = (length >> 8) & 0xff;
+                memcpy(value + 2, data_value.chars().data(), length);
+                break;
+            case DATE:
+                words[0] = 0;
+                utils::setTwoBytes(words[0], 0, data_value.value.dateValue.year);
+                utils::setByte(words[0], 2, data_value.value.dateValue.month);
+                utils::setByte(words[0], 3, data_value.value.dateValue.day);
+                memcpy(value, words, BYTE_PER_BUF);
+                break;
+        }
+    }
+}
+
+bool RecordManager::pageHasRoom(const BufType b, const RecordLayout& layout) {
+    if (layout.slotted) return slottedHasRoom(b, layout.min_item_length);
+    return firstFreeSlot(b, layout.data_item_per_page) != -1;
+}
+
+BufType RecordManager::scanPage(int file_id, int page_id,
+                                const RecordLayout& layout, fs::PageGuard& pin,
+                                bool shared) {
+    if (layout.slotted || shared) {
+        pin = fs::PageGuard(bpm, file_id, page_id);
+        return pin.data();
+    }
+    int index;
+    BufType b = bpm->getPageReadOnly(file_id, page_id, index);
+    bpm->accessPage(index);
+    return b;
+}
+
+const unsigned char* RecordManager::slotRecord(int file_id, const BufType b,
+                                               int slot_id,
+                                               const RecordLayout& layout,
+                                               fs::PageGuard& forwarded) {
+    if (layout.pax) return pageBytes(b) + RECORD_PAGE_HEADER;
+    if (!layout.slotted) {
+        return pageBytes(b) + RECORD_PAGE_HEADER + slot_id * layout.data_item_length;
+    }
+    unsigned int entry = slotEntry(b, slot_id);
+    if (entry & SLOTTED_MOVED_IN) return nullptr;
+    if (entry & SLOTTED_FORWARD) {
+        RecordLocation target = forwardTarget(b, slot_id);
+        forwarded = fs::PageGuard(bpm, file_id, target.pageId);
+        BufType target_b = forwarded.data();
+        return pageBytes(target_b) + entryOffset(slotEntry(target_b, target.slotId));
+    }
+    return pageBytes(b) + entryOffset(entry);
+}
+
+bool RecordManager::readSlot(int file_id, const BufType b, int slot_id,
+                             const RecordLayout& layout,
+                             const RowLayout& row_layout, DataItem& data_item,
+                             const ColumnMask& column_mask) {
+    fs::PageGuard forwarded;
+    const unsigned char* record = slotRecord(file_id, b, slot_id, layout, forwarded);
+    if (record == nullptr) return false;
+    data_item = RowView(row_layout, record, slot_id).materialize(column_mask);
+    return true;
+}
+
+void RecordManager::encodeSlottedItem(int record_id, const DataItem& data_item,
+                                      const std::vector<ColumnType>& column_types,
+                                      std::vector<unsigned char>& tuple) {
+    int column_num = column_types.size();
+    int null_bytes = (column_num + 7) / 8;
+    tuple.assign(4 + null_bytes, 0);
+    unsigned int word = record_id;
+    memcpy(tuple.data(), &word, 4);
+    auto append_word = [&tuple](unsigned int value) {
+        unsigned char bytes[4];
+        memcpy(bytes, &value, 4);
+        tuple.insert(tuple.end(), bytes, bytes + 4);
+    };
+    for (int columnId = 0; columnId < column_num; columnId++) {
+        auto& data_value = data_item.values[columnId];
+        if (data_value.isNull) {
+            tuple[4 + columnId / 8] |= 1 << (columnId % 8);
+            continue;
+        }
+        unsigned int first_word, second_word;
+        switch (column_types[columnId].dataType) {
+            case INT:
+                append_word(utils::intToBit32(data_value.value.intValue));
+                break;
+            case FLOAT:
+                utils::floatToBit32(data_value.value.floatValue, first_word,
+                                    second_word);
+                append_word(first_word);
+                append_word(second_word);
+                break;
+            case VARCHAR: {
+                auto chars = data_value.chars();
+                tuple.push_back(chars.size() & 0xff);
+                tuple.push_back((chars.size() >> 8) & 0xff);
+                tuple.insert(tuple.end(), chars.begin(), chars.end());
+                break;
+            }
+            case DATE:
+                first_word = 0;
+                utils::setTwoBytes(first_word, 0, data_value.value.dateValue.year);
+                utils::setByte(first_word, 2, data_value.value.dateValue.month);
+                utils::setByte(first_word, 3, data_value.value.dateValue.day);
+                append_word(first_word);
+                break;
+        }
+    }
+}
+
+RecordLocation RecordManager::placeSlottedTuple(
+    int file_id, int fsm_id, BufType meta_b, const RecordLayout& layout,
+    const std::vector<unsigned char>& tuple, unsigned int flags) {
+    int page_num = meta_b[5];
+    int pageId;
+    while ((pageId = findFreePage(fsm_id, page_num)) != -1) {
+        fs::PageGuard page(bpm, file_id, pageId);
+        BufType b = page.data();
+        page.markDirty();
+        int slotId = allocateSlottedTuple(b, tuple.size());
+        if (slotId == -1) {
+            // Too little room for this tuple; deletes free the page again
+            setPageSummary(b, countLiveSlots(b), true);
+            setPageFree(fsm_id, pageId, false);
+            continue;
+        }
+        writeSlottedTuple(b, slotId, tuple.data(), tuple.size(), flags);
+        bool room = slottedHasRoom(b, layout.min_item_length);
+        setPageSummary(b, countLiveSlots(b), !room);
+        if (!room) setPageFree(fsm_id, pageId, false);
+        return RecordLocation{pageId, slotId};
+    }
+
+    pageId = page_num + 1;
+    fs::PageGuard page(bpm, file_id, pageId);
+    BufType b = page.data();
+    initSlottedPage(b);
+    int slotId = allocateSlottedTuple(b, tuple.size());
+    assert(slotId == 0);
+    writeSlottedTuple(b, slotId, tuple.data(), tuple.size(), flags);
+    bool room = slottedHasRoom(b, layout.min_item_length);
+    setPageSummary(b, 1, !room);
+    page.markDirty();
+    meta_b[5] = pageId;
+    appendFreeSpaceMapPage(fsm_id, pageId, room);
+    return RecordLocation{pageId, slotId};
+}
+
+void RecordManager::releaseSlottedTuple(int file_id, int fsm_id,
+                                        const RecordLayout& layout,
+                                        const RecordLocation& location) {
+    fs::PageGuard page(bpm, file_id, location.pageId);
+    BufType b = page.data();
+    freeSlottedTuple(b, location.slotId);
+    bool room = slottedHasRoom(b, layout.min_item_length);
+    setPageSummary(b, countLiveSlots(b), !room);
+    page.markDirty();
+    if (room) setPageFree(fsm_id, location.pageId, true);
+}
+
+void RecordManager::appendFreeSpaceMapPage(int fsm_id, int page_id, bool free) {
+    int index;
+    if ((page_id - 1) % BIT_PER_PAGE == 0) {  // first page of a new map page
+        BufType map = bpm->getPage(fsm_id, (page_id - 1) / BIT_PER_PAGE + 1, index);
+        memset(map, 0, PAGE_SIZE_BY_BYTE);
+        bpm->markPageDirty(index);
+    }
+    BufType header = bpm->getPage(fsm_id, 0, index);
+    header[2] = page_id;
+    bpm->markPageDirty(index);
+    if (free) setPageFree(fsm_id, page_id, true);
+}
+
 void RecordManager::sortDataItem(const std::vector<ColumnType>& column_types,
                                  DataItem& data_item) {
     std::vector<DataValue> sorted_data_values;
@@ -811,7 +1434,7 @@ int RecordManager::getTotalPageNum(const char* file_path) {
     assert(file_id != -1);
     BufType b;
     int index;
-    b = bpm->getPage(file_id, 0, index);
+    b = bpm->getPageReadOnly(file_id, 0, index);
     int page_num = b[5];
     bpm->accessPage(index);
     return page_num;
@@ -819,74 +1442,84 @@ int RecordManager::getTotalPageNum(const char* file_path) {
 
 void RecordManager::getRecordsInPageRange(const char* file_path,
                                           std::vector<DataItem>& data_items,
-                                          int low_page, int upper_page) {
+                                          int low_page, int upper_page,
+                                          const ColumnMask& column_mask) {
     data_items.clear();
     int file_id = openFile(file_path);
     assert(file_id != -1);
 
-    std::vector<ColumnType> column_types;
-    getColumnTypes(file_path, column_types);
+    TableSchemaPtr schema = getSchema(file_path);
+    const RecordLayout& layout = schema->layout;
+    const RowLayout& row_layout = schema->row_layout;
 
-    BufType b;
-    int index;
-    b = bpm->getPage(file_id, 0, index);
-    int page_num = b[5];
-    int null_bitmap_buf_size = b[7];
-    bpm->accessPage(index);
-    int data_item_length =
-        dataItemLength(column_types, null_bitmap_buf_size * BYTE_PER_BUF);
-    int data_item_per_page = std::min(
-        (PAGE_SIZE_BY_BYTE - RECORD_PAGE_HEADER) / data_item_length, MAX_ITEM_PER_PAGE);
+    std::vector<RecordLocation> record_locations;
+    bpm->beginScan(file_id, low_page, upper_page);
+    scanPageRange(file_id, layout, row_layout, ScanFilter(), column_mask,
+                  low_page, upper_page, false, data_items, record_locations);
+    bpm->endScan(file_id);
+}
 
+void RecordManager::scanPageRange(int file_id, const RecordLayout& layout,
+                                  const RowLayout& row_layout,
+                                  const ScanFilter& filter,
+                                  const ColumnMask& column_mask, int low_page,
+                                  int upper_page, bool shared,
+                                  std::vector<DataItem>& data_items,
+                                  std::vector<RecordLocation>& record_locations) {
+    DataValue scratch;
+    unsigned int selection[SLOT_SELECTION_BUF];
     for (int pageId = low_page; pageId < upper_page; pageId++) {
-        b = bpm->getPage(file_id, pageId, index);
-        bpm->accessPage(index);
-        for (int slotId = 0; slotId < data_item_per_page; slotId++) {
-            if (!utils::getBitFromBuffer(b, slotId)) continue;
-            data_items.push_back(
-                getSlotItem(b, slotId,
-                            dataItemLength(column_types,
-                                           null_bitmap_buf_size * BYTE_PER_BUF),
-                            null_bitmap_buf_size, column_types));
-        }
+        fs::PageGuard pin;
+        BufType b = scanPage(file_id, pageId, layout, pin, shared);
+        selectSlots(b, layout.data_item_per_page, row_layout, filter, selection);
+        forEachSelectedSlot(selection, layout.data_item_per_page, [&](int slotId) {
+            fs::PageGuard forwarded;
+            const unsigned char* record =
+                slotRecord(file_id, b, slotId, layout, forwarded);
+            if (record == nullptr) return;
+            RowView view(row_layout, record, slotId);
+            if (matchesConstraints(view, filter.residual, scratch)) {
+                data_items.push_back(view.materialize(column_mask));
+                record_locations.push_back(RecordLocation{pageId, slotId});
+            }
+        });
     }
 }
 
 void RecordManager::getAllRecords(
     const char* file_path, std::vector<DataItem>& data_items,
-    std::vector<RecordLocation>& record_locations) {
+    std::vector<RecordLocation>& record_locations,
+    const ColumnMask& column_mask) {
     data_items.clear();
     record_locations.clear();
     int file_id = openFile(file_path);
     assert(file_id != -1);
 
-    std::vector<ColumnType> column_types;
-    getColumnTypes(file_path, column_types);
+    TableSchemaPtr schema = getSchema(file_path);
+    const RecordLayout& layout = schema->layout;
+    const RowLayout& row_layout = schema->row_layout;
 
     BufType b;
     int index;
-    b = bpm->getPage(file_id, 0, index);
+    b = bpm->getPageReadOnly(file_id, 0, index);
     int page_num = b[5];
-    int null_bitmap_buf_size = b[7];
     bpm->accessPage(index);
-    int data_item_length =
-        dataItemLength(column_types, null_bitmap_buf_size * BYTE_PER_BUF);
-    int data_item_per_page = std::min(
-        (PAGE_SIZE_BY_BYTE - RECORD_PAGE_HEADER) / data_item_length, MAX_ITEM_PER_PAGE);
 
+    DataItem data_item;
+    bpm->beginScan(file_id, 1, page_num + 1);
     for (int pageId = 1; pageId <= page_num; pageId++) {
-        b = bpm->getPage(file_id, pageId, index);
-        bpm->accessPage(index);
-        for (int slotId = 0; slotId < data_item_per_page; slotId++) {
-            if (!utils::getBitFromBuffer(b, slotId)) continue;
-            data_items.push_back(
-                getSlotItem(b, slotId,
-                            dataItemLength(column_types,
-                                           null_bitmap_buf_size * BYTE_PER_BUF),
-                            null_bitmap_buf_size, column_types));
+        fs::PageGuard pin;
+        b = scanPage(file_id, pageId, layout, pin);
+        forEachLiveSlot(b, layout.data_item_per_page, [&](int slotId) {
+            if (!readSlot(file_id, b, slotId, layout, row_layout, data_item,
+                          column_mask)) {
+                return;
+            }
+            data_items.push_back(data_item);
             record_locations.push_back(RecordLocation{pageId, slotId});
-        }
+        });
     }
+    bpm->endScan(file_id);
 }
 
 int RecordManager::getAllRecordWithConstraintSaveFile(
@@ -895,8 +1528,10 @@ int RecordManager::getAllRecordWithConstraintSaveFile(
     int file_id = openFile(file_path);
     assert(file_id != -1);
 
-    std::vector<ColumnType> column_types;
-    getColumnTypes(file_path, column_types);
+    TableSchemaPtr schema = getSchema(file_path);
+    const std::vector<ColumnType>& column_types = schema->columns;
+    const RecordLayout& layout = schema->layout;
+    const RowLayout& row_layout = schema->row_layout;
 
     std::ofstream outputFile(file_path_save);
     if (!outputFile.is_open()) {
@@ -907,33 +1542,26 @@ int RecordManager::getAllRecordWithConstraintSaveFile(
     int cnt = 0;
     BufType b;
     int index;
-    b = bpm->getPage(file_id, 0, index);
+    b = bpm->getPageReadOnly(file_id, 0, index);
     int page_num = b[5];
-    int null_bitmap_buf_size = b[7];
     bpm->accessPage(index);
-    int data_item_length =
-        dataItemLength(column_types, null_bitmap_buf_size * BYTE_PER_BUF);
-    int data_item_per_page = std::min(
-        (PAGE_SIZE_BY_BYTE - RECORD_PAGE_HEADER) / data_item_length, MAX_ITEM_PER_PAGE);
+    ScanFilter filter = planScanFilter(constraints, column_types, row_layout);
 
+    DataValue scratch;
+    unsigned int selection[SLOT_SELECTION_BUF];
+    bpm->beginScan(file_id, 1, page_num + 1);
     for (int pageId = 1; pageId <= page_num; pageId++) {
-        b = bpm->getPage(file_id, pageId, index);
-        bpm->accessPage(index);
-        for (int slotId = 0; slotId < data_item_per_page; slotId++) {
-            if (!utils::getBitFromBuffer(b, slotId)) continue;
-            auto data_item =
-                getSlotItem(b, slotId,
-                            dataItemLength(column_types,
-                                           null_bitmap_buf_size * BYTE_PER_BUF),
-                            null_bitmap_buf_size, column_types);
-            bool valid = true;
-            for (auto& constraint : constraints) {
-                if (!system::validConstraint(constraint, data_item)) {
-                    valid = false;
-                    break;
-                }
-            }
-            if (valid) {
+        fs::PageGuard pin;
+        b = scanPage(file_id, pageId, layout, pin);
+        selectSlots(b, layout.data_item_per_page, row_layout, filter, selection);
+        forEachSelectedSlot(selection, layout.data_item_per_page, [&](int slotId) {
+            fs::PageGuard forwarded;
+            const unsigned char* record =
+                slotRecord(file_id, b, slotId, layout, forwarded);
+            if (record == nullptr) return;
+            RowView view(row_layout, record, slotId);
+            if (matchesConstraints(view, filter.residual, scratch)) {
+                DataItem data_item = view.materialize();
                 for (int i = 0; i < data_item.values.size() - 1; i++) {
                     outputFile << data_item.values[i].toString() << ",";
                 }
@@ -941,8 +1569,9 @@ int RecordManager::getAllRecordWithConstraintSaveFile(
                 outputFile << std::endl;
                 cnt++;
             }
-        }
+        });
     }
+    bpm->endScan(file_id);
     outputFile.close();
     return cnt;
 }
@@ -950,49 +1579,58 @@ int RecordManager::getAllRecordWithConstraintSaveFile(
 void RecordManager::getAllRecordWithConstraint(
     const char* file_path, std::vector<DataItem>& data_items,
     std::vector<RecordLocation>& record_locations,
-    const std::vector<system::SearchConstraint>& constraints) {
+    const std::vector<system::SearchConstraint>& constraints,
+    const ColumnMask& column_mask) {
     data_items.clear();
     record_locations.clear();
     int file_id = openFile(file_path);
     assert(file_id != -1);
 
-    std::vector<ColumnType> column_types;
-    getColumnTypes(file_path, column_types);
+    TableSchemaPtr schema = getSchema(file_path);
+    const std::vector<ColumnType>& column_types = schema->columns;
+    const RecordLayout& layout = schema->layout;
+    const RowLayout& row_layout = schema->row_layout;
 
     BufType b;
     int index;
-    b = bpm->getPage(file_id, 0, index);
+    b = bpm->getPageReadOnly(file_id, 0, index);
     int page_num = b[5];
-    int null_bitmap_buf_size = b[7];
     bpm->accessPage(index);
-    int data_item_length =
-        dataItemLength(column_types, null_bitmap_buf_size * BYTE_PER_BUF);
-    int data_item_per_page = std::min(
-        (PAGE_SIZE_BY_BYTE - RECORD_PAGE_HEADER) / data_item_length, MAX_ITEM_PER_PAGE);
+    ScanFilter filter = planScanFilter(constraints, column_types, row_layout);
+
+    int morsel_num = (page_num + SCAN_MORSEL_PAGES - 1) / SCAN_MORSEL_PAGES;
+    bpm->beginScan(file_id, 1, page_num + 1);
+    if (morsel_num < 2 || scan_workers->size() < 2) {
+        scanPageRange(file_id, layout, row_layout, filter, column_mask, 1,
+                      page_num + 1, false, data_items, record_locations);
+        bpm->endScan(file_id);
+        return;
+    }
 
-    for (int pageId = 1; pageId <= page_num; pageId++) {
-        b = bpm->getPage(file_id, pageId, index);
-        bpm->accessPage(index);
-        for (int slotId = 0; slotId < data_item_per_page; slotId++) {
-            if (!utils::getBitFromBuffer(b, slotId)) continue;
-            auto data_item =
-                getSlotItem(b, slotId,
-                            dataItemLength(column_types,
-                                           null_bitmap_buf_size * BYTE_PER_BUF),
-                            null_bitmap_buf_size, column_types);
-            bool valid = true;
-            for (auto& constraint : constraints) {
-                if (!system::validConstraint(constraint, data_item)) {
-                    valid = false;
-                    break;
-                }
-            }
-            if (valid) {
-                data_items.push_back(data_item);
-                record_locations.push_back(RecordLocation{pageId, slotId});
-            }
-        }
+    // Each morsel collects its own rows; concatenating them in page order
+    // returns the rows in the same order as a serial scan
+    std::vector<std::vector<DataItem>> morsel_items(morsel_num);
+    std::vector<std::vector<RecordLocation>> morsel_locations(morsel_num);
+    scan_workers->run(morsel_num, [&](int morsel) {
+        int low_page = 1 + morsel * SCAN_MORSEL_PAGES;
+        int upper_page = std::min(low_page + SCAN_MORSEL_PAGES, page_num + 1);
+        scanPageRange(file_id, layout, row_layout, filter, column_mask,
+                      low_page, upper_page, true, morsel_items[morsel],
+                      morsel_locations[morsel]);
+    });
+    bpm->endScan(file_id);
+
+    size_t total = 0;
+    for (auto& items : morsel_items) total += items.size();
+    data_items.reserve(total);
+    record_locations.reserve(total);
+    for (int morsel = 0; morsel < morsel_num; morsel++) {
+        std::move(morsel_items[morsel].begin(), morsel_items[morsel].end(),
+                  std::back_inserter(data_items));
+        record_locations.insert(record_locations.end(),
+                                morsel_locations[morsel].begin(),
+                                morsel_locations[morsel].end());
     }
 }
 }  // namespace record
-}  // namespace dbs
\ No newline at end of file
+}  // namespace dbs
@@ -0,0 +1,159 @@
+#include "record/RowView.hpp"
+
+#include <cstring>
+
+namespace dbs {
+namespace record {
+
+namespace {
+
+const int RECORD_ID_BYTES = 4;
+const int VARCHAR_LENGTH_BYTES = 2;
+
+unsigned int readWord(const unsigned char* p) {
+    unsigned int word;
+    memcpy(&word, p, sizeof(word));
+    return word;
+}
+
+int varcharLength(const unsigned char* p) { return p[0] | p[1] << 8; }
+
+}  // namespace
+
+RowLayout::RowLayout(const std::vector<ColumnType>& column_types,
+                     RecordFormat format_, int null_bitmap_buf_size,
+                     int items_per_page_, int slot_stride_)
+    : format(format_), items_per_page(items_per_page_), slot_stride(slot_stride_) {
+    int column_num = column_types.size();
+    null_bytes = null_bitmap_buf_size * BYTE_PER_BUF;
+    values_offset = format == RecordFormat::SLOTTED
+                        ? RECORD_ID_BYTES + (column_num + 7) / 8
+                        : RECORD_ID_BYTES + null_bytes;
+    // A PAX minipage holds one value per slot of the page
+    int scale = format == RecordFormat::PAX ? items_per_page : 1;
+    int offset = values_offset;
+    for (auto& column_type : column_types) {
+        data_types.push_back(column_type.dataType);
+        column_ids.push_back(column_type.columnId);
+        if (format == RecordFormat::SLOTTED) continue;
+        int width = column_type.dataType == VARCHAR
+                        ? column_type.varcharSpace + VARCHAR_LENGTH_BYTES
+                        : getDataTypeSize(column_type.dataType);
+        column_offsets.push_back(offset * scale);
+        column_widths.push_back(width);
+        offset += width;
+    }
+}
+
+unsigned int RowView::recordId() const {
+    if (layout->format == RecordFormat::PAX) {
+        return readWord(record + slot * RECORD_ID_BYTES);
+    }
+    return readWord(record);
+}
+
+bool RowView::isNull(int column) const {
+    if (layout->format == RecordFormat::PAX) {
+        const unsigned char* null_bitmap = record +
+                                           layout->items_per_page * RECORD_ID_BYTES +
+                                           slot * layout->null_bytes;
+        return null_bitmap[column / 8] >> (column % 8) & 1;
+    }
+    return record[RECORD_ID_BYTES + column / 8] >> (column % 8) & 1;
+}
+
+const unsigned char* RowView::valueAt(int column) const {
+    if (layout->format == RecordFormat::PAX) {
+        return record + layout->column_offsets[column] +
+               slot * layout->column_widths[column];
+    }
+    if (layout->format == RecordFormat::FIXED) {
+        return record + layout->column_offsets[column];
+    }
+    if (walked == 0) {
+        offsets[0] = layout->values_offset;
+        walked = 1;
+    }
+    // Null values take no space; a VARCHAR takes its length prefix plus data
+    while (walked <= column) {
+        int previous = walked - 1;
+        int width = 0;
+        if (!isNull(previous)) {
+            const unsigned char* p = record + offsets[previous];
+            width = layout->data_types[previous] == VARCHAR
+                        ? VARCHAR_LENGTH_BYTES + varcharLength(p)
+                        : getDataTypeSize(layout->data_types[previous]);
+        }
+        offsets[walked] = offsets[previous] + width;
+        walked++;
+    }
+    return record + offsets[column];
+}
+
+int RowView::getInt(int column) const {
+    return static_cast<int>(readWord(valueAt(column)));
+}
+
+double RowView::getFloat(int column) const {
+    double value;
+    memcpy(&value, valueAt(column), sizeof(value));
+    return value;
+}
+
+std::string_view RowView::getVarchar(int column) const {
+    const unsigned char* p = valueAt(column);
+    return std::string_view(reinterpret_cast<const char*>(p + VARCHAR_LENGTH_BYTES),
+                            varcharLength(p));
+}
+
+DateValue RowView::getDate(int column) const {
+    const unsigned char* p = valueAt(column);
+    return DateValue(p[0] | p[1] << 8, static_cast<char>(p[2]),
+                     static_cast<char>(p[3]));
+}
+
+void RowView::getValue(int column, DataValue& value) const {
+    value.dataType = layout->data_types[column];
+    value.isNull = isNull(column);
+    if (value.isNull) return;
+    switch (value.dataType) {
+        case INT:
+            value.setInt(getInt(column));
+            break;
+        case FLOAT:
+            value.setFloat(getFloat(column));
+            break;
+        case VARCHAR:
+            value.setChars(getVarchar(column));
+            break;
+        case DATE:
+            value.setDate(getDate(column));
+            break;
+        default:
+            break;
+    }
+}
+
+DataItem RowView::materialize() const { return materialize(ColumnMask()); }
+
+DataItem RowView::materialize(const ColumnMask& column_mask) const {
+    DataItem data_item;
+    data_item.dataId = recordId();
+    int column_num = layout->columnCount();
+    data_item.values.reserve(column_num);
+    data_item.columnIds = layout->column_ids;
+    for (int column = 0; column < column_num; column++) {
+        int column_id = layout->column_ids[column];
+        if (!column_mask.empty() &&
+            (column_id >= column_mask.size() || !column_mask[column_id])) {
+            data_item.values.emplace_back(layout->data_types[column], true);
+            continue;
+        }
+        data_item.values.emplace_back(layout->data_types[column], isNull(column));
+        getValue(column, data_item.values.back());
+    }
+    return data_item;
+}
+
+}  // namespace record
+}  // namespace dbs
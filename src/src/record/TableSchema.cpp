@@ -0,0 +1,26 @@
+#include "record/TableSchema.hpp"
+
+#include <utility>
+
+namespace dbs {
+namespace record {
+
+namespace {
+
+RecordFormat layoutFormat(const RecordLayout& layout) {
+    return layout.slotted ? RecordFormat::SLOTTED
+           : layout.pax   ? RecordFormat::PAX
+                          : RecordFormat::FIXED;
+}
+
+}  // namespace
+
+TableSchema::TableSchema(std::vector<ColumnType> columns_,
+                         const RecordLayout& layout_)
+    : columns(std::move(columns_)),
+      layout(layout_),
+      row_layout(columns, layoutFormat(layout_), layout_.null_bitmap_buf_size,
+                 layout_.data_item_per_page, layout_.data_item_length) {}
+
+}  // namespace record
+}  // namespace dbs
@@ -256,63 +256,70 @@ bool mergeConstraints(std::vector<SearchConstraint>& constraints) {
     return valid;
 }
 
-bool validConstraint(const SearchConstraint& constraint,
-                     const record::DataItem& item) {
-    for (int i = 0; i < item.columnIds.size(); i++) {
-        if (constraint.columnId == item.columnIds[i]) {
-            for (int j = 0; j < constraint.constraintTypes.size(); j++) {
-                if (constraint.constraintValues[j].isNull) {
-                    if (constraint.constraintTypes[j] == ConstraintType::EQ) {
-                        if (!item.values[i].isNull) {
-                            return false;
-                        }
-                    } else if (constraint.constraintTypes[j] ==
-                               ConstraintType::NEQ) {
-                        if (item.values[i].isNull) {
-                            return false;
-                        }
-                    }
-                    continue;
+bool validConstraintValue(const SearchConstraint& constraint,
+                          const record::DataValue& value) {
+    for (int j = 0; j < constraint.constraintTypes.size(); j++) {
+        if (constraint.constraintValues[j].isNull) {
+            if (constraint.constraintTypes[j] == ConstraintType::EQ) {
+                if (!value.isNull) {
+                    return false;
                 }
-                if (constraint.constraintTypes[j] == ConstraintType::EQ) {
-                    if (!(item.values[i] ==constraint.constraintValues[j])) {
-                        return false;
-                    }
-                } 
-                else if (constraint.constraintTypes[j] ==
-                           ConstraintType::NEQ) {
-                    if (item.values[i] ==
-                        constraint.constraintValues[j]) {
-                        return false;
-                    }
-                } else if (constraint.constraintTypes[j] ==
-                           ConstraintType::GT) {
-                    if (item.values[i] <=
-                            constraint.constraintValues[j] ||
-                        item.values[i].isNull) {
-                        return false;
-                    }
-                } else if (constraint.constraintTypes[j] ==
-                           ConstraintType::GEQ) {
-                    if (item.values[i] < constraint.constraintValues[j] ||
-                        item.values[i].isNull) {
-                        return false;
-                    }
-                } else if (constraint.constraintTypes[j] ==
-                           ConstraintType::LT) {
-                    if (item.values[i] >=
-                            constraint.constraintValues[j] ||
-                        item.values[i].isNull) {
-                        return false;
-                    }
-                } else if (constraint.constraintTypes[j] ==
-                           ConstraintType::LEQ) {
-                    if (item.values[i] > constraint.constraintValues[j] ||
-                        item.values[i].isNull) {
-                        return false;
-                    }
+            } else if (constraint.constraintTypes[j] ==
+                       ConstraintType::NEQ) {
+                if (value.isNull) {
+                    return false;
                 }
             }
+            continue;
+        }
+        if (constraint.constraintTypes[j] == ConstraintType::EQ) {
+            if (!(value ==constraint.constraintValues[j])) {
+                return false;
+            }
+        } 
+        else if (constraint.constraintTypes[j] ==
+                   ConstraintType::NEQ) {
+            if (value ==
+                constraint.constraintValues[j]) {
+                return false;
+            }
+        } else if (constraint.constraintTypes[j] ==
+                   ConstraintType::GT) {
+            if (value <=
+                    constraint.constraintValues[j] ||
+                value.isNull) {
+                return false;
+            }
+        } else if (constraint.constraintTypes[j] ==
+                   ConstraintType::GEQ) {
+            if (value < constraint.constraintValues[j] ||
+                value.isNull) {
+                return false;
+            }
+        } else if (constraint.constraintTypes[j] ==
+                   ConstraintType::LT) {
+            if (value >=
+                    constraint.constraintValues[j] ||
+                value.isNull) {
+                return false;
+            }
+        } else if (constraint.constraintTypes[j] ==
+                   ConstraintType::LEQ) {
+            if (value > constraint.constraintValues[j] ||
+                value.isNull) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool validConstraint(const SearchConstraint& constraint,
+                     const record::DataItem& item) {
+    for (int i = 0; i < item.columnIds.size(); i++) {
+        if (constraint.columnId == item.columnIds[i] &&
+            !validConstraintValue(constraint, item.values[i])) {
+            return false;
         }
     }
     return true;
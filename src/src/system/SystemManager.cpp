@@ -1,5 +1,9 @@
 #include "system/SystemManager.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+
 namespace dbs {
 namespace system {
 
@@ -8,6 +12,7 @@ SystemManager::SystemManager(fs::FileManager* fm_, record::RecordManager* rm_,
     : fm(fm_), rm(rm_), im(im_) {
     currentDatabaseId = -1;
     currentDatabaseName = "";
+    tableRecordFormat = record::RecordFormat::FIXED;
 
     GlobalDatabaseInfoColumnType.clear();
     GlobalDatabaseInfoColumnType.push_back(
@@ -67,7 +72,7 @@ SystemManager::~SystemManager() {
 }
 
 void SystemManager::cleanSystem() {
-    rm->cleanAllCurrentColumnTypes();
+    rm->invalidateAllSchemas();
     rm->closeAllCurrentFile();
     im->closeAllCurrentFile();
     if (fm->doesFolderExist(DATABASE_PATH)) {
@@ -77,7 +82,7 @@ void SystemManager::cleanSystem() {
 }
 
 void SystemManager::initializeSystem() {
-    rm->cleanAllCurrentColumnTypes();
+    rm->invalidateAllSchemas();
     rm->closeAllCurrentFile();
     im->closeAllCurrentFile();
     if (!fm->doesFolderExist(DATABASE_PATH)) {
@@ -147,7 +152,7 @@ bool SystemManager::dropDatabase(const char* database_name) {
 
     im->closeAllCurrentFile();
     rm->closeAllCurrentFile();
-    rm->cleanAllCurrentColumnTypes();
+    rm->invalidateAllSchemas();
 
     char* database_path = nullptr;
     getDatabasePath(database_id, &database_path);
@@ -181,8 +186,7 @@ int SystemManager::getDatabaseId(const char* database_name) {
 
     // searchRowsInTable for the database name
     for (auto& item : data_items) {
-        if (strcmp(item.values[0].value.charValue.c_str(),
-                   database_name) == 0) {
+        if (item.values[0].chars() == database_name) {
             return item.dataId;
         }
     }
@@ -220,8 +224,8 @@ bool SystemManager::deleteForeignKey(const char* table_name,
 
     for (int i = 0; i < data_items.size(); i++) {
         auto& data_item = data_items[i];
-        std::string name =
-            data_item.values[FOREIGN_KEY_MAX_NUM * 2 + 1].value.charValue;
+        std::string name(
+            data_item.values[FOREIGN_KEY_MAX_NUM * 2 + 1].chars());
         if (name != foreign_key_name) {
             continue;
         }
@@ -348,10 +352,10 @@ bool SystemManager::addForeignKey(const char* table_name,
         }
 
         std::vector<record::DataItem> result_datas;
-        std::vector<record::ColumnType> result_column_types;
+        record::TableSchemaPtr result_schema;
         std::vector<record::RecordLocation> record_locations;
         searchRowsInTable(new_foreign_key.reference_table_id, constraints, result_datas,
-               result_column_types, record_locations, -1);
+               result_schema, record_locations, -1);
         if (result_datas.size() == 0) {
             std::cout << "!ERROR" << std::endl;
             std::cout << "foreign" << std::endl;
@@ -616,7 +620,7 @@ bool SystemManager::createTable(
     // Record path
     char* record_path = nullptr;
     utils::joinPaths(table_path, RECORD_FILE_NAME, &record_path);
-    rm->initializeRecordFile(record_path, column_types);
+    rm->initializeRecordFile(record_path, column_types, tableRecordFormat);
     delete[] record_path;
 
     // primary key path
@@ -774,7 +778,7 @@ bool SystemManager::addIndex(const char* table_name,
         auto& data_item = data_items[i];
         auto& origin_index_name = data_item.values[INDEX_KEY_MAX_NUM];
         if (!origin_index_name.isNull &&
-            origin_index_name.value.charValue == index_name) {
+            origin_index_name.chars() == index_name) {
             std::cout << "!ERROR" << std::endl;
             std::cout << "Index already exists" << std::endl;
             delete[] table_path;
@@ -808,8 +812,7 @@ bool SystemManager::addIndex(const char* table_name,
             if (same) {
                 if (origin_index_name.isNull) {
                     data_item.values[INDEX_KEY_MAX_NUM].isNull = false;
-                    data_item.values[INDEX_KEY_MAX_NUM].value.charValue =
-                        index_name;
+                    data_item.values[INDEX_KEY_MAX_NUM].setChars(index_name);
                     data_item.values[INDEX_KEY_MAX_NUM].dataType =
                         record::DataTypeIdentifier::VARCHAR;
                     rm->updateRecord(index_info_path, record_locations[i],
@@ -869,42 +872,42 @@ bool SystemManager::addIndex(const char* table_name,
     char* index_file_path = nullptr;
     getIndexRecordPath(currentDatabaseId, table_id, index_id,
                        &index_file_path);
-    std::vector<record::ColumnType> index_column_types;
-    rm->getColumnTypes(index_file_path, index_column_types);
 
     // get all data from record file
     rm->getAllRecords(record_path, data_items, record_locations);
 
-    // insert into index
+    // build the index from the sorted keys of every row
+    index::IndexSorter entries(index_file_path);
+    std::vector<int> keys(columnIds.size());
     for (int i = 0; i < data_items.size(); i++) {
         auto& data_item = data_items[i];
         auto& location = record_locations[i];
-        index::IndexValue insert_item(location.pageId, location.slotId, 0);
         for (int j = 0; j < columnIds.size(); j++) {
             int columnId = columnIds[j];
             for (int k = 0; k < data_item.values.size(); k++) {
                 if (data_item.columnIds[k] == columnId) {
-                    insert_item.key.push_back(
-                        data_item.values[k].value.intValue);
+                    keys[j] = data_item.values[k].value.intValue;
                     break;
                 }
             }
         }
-        if (check_unique) {
-            std::vector<index::IndexValue> search_results;
-            im->searchIndex(index_file_path, insert_item, search_results);
-            if (search_results.size() > 0) {
-                std::cout << "!ERROR" << std::endl;
-                std::cout << "duplicate" << std::endl;
-                dropIndex(table_name, index_name);
-                delete[] table_path;
-                delete[] index_info_path;
-                delete[] record_path;
-                delete[] index_file_path;
-                return false;
-            }
+        entries.add(location.pageId, location.slotId, keys.data(),
+                    keys.size());
+    }
+    if (!im->bulkBuildIndex(index_file_path, columnIds.size(), entries,
+                            check_unique)) {
+        std::cout << "!ERROR" << std::endl;
+        if (entries.failed()) {
+            std::cout << "Failed to sort index entries" << std::endl;
+        } else {
+            std::cout << "duplicate" << std::endl;
         }
-        im->insertIndex(index_file_path, insert_item);
+        dropIndex(table_name, index_name);
+        delete[] table_path;
+        delete[] index_info_path;
+        delete[] record_path;
+        delete[] index_file_path;
+        return false;
     }
     delete[] index_file_path;
     delete[] record_path;
@@ -942,7 +945,7 @@ bool SystemManager::dropIndex(const char* table_name,
         auto& data_item = data_items[i];
         auto& origin_index_name = data_item.values[INDEX_KEY_MAX_NUM];
         if (!origin_index_name.isNull &&
-            origin_index_name.value.charValue == index_name) {
+            origin_index_name.chars() == index_name) {
             // delete index
             rm->deleteRecord(index_info_path, record_locations[i]);
             // delete index file
@@ -960,7 +963,7 @@ bool SystemManager::dropIndex(const char* table_name,
         auto& data_item = data_items[i];
         auto& origin_index_name = data_item.values[INDEX_KEY_MAX_NUM];
         if (!origin_index_name.isNull &&
-            origin_index_name.value.charValue == index_name_with_unique) {
+            origin_index_name.chars() == index_name_with_unique) {
             // delete index
             rm->deleteRecord(index_info_path, record_locations[i]);
             // delete index file
@@ -996,7 +999,7 @@ int SystemManager::_createIndex (const char* index_info_path,
 
     for (int i = 0; i < index_ids.size(); i++) {
         data_item.values[i].isNull = false;
-        data_item.values[i].value.intValue = index_ids[i];
+        data_item.values[i].setInt(index_ids[i]);
     }
     if (name == "") {
         // null
@@ -1005,7 +1008,7 @@ int SystemManager::_createIndex (const char* index_info_path,
             record::DataTypeIdentifier::VARCHAR;
     } else {
         data_item.values[INDEX_KEY_MAX_NUM].isNull = false;
-        data_item.values[INDEX_KEY_MAX_NUM].value.charValue = name;
+        data_item.values[INDEX_KEY_MAX_NUM].setChars(name);
         data_item.values[INDEX_KEY_MAX_NUM].dataType =
             record::DataTypeIdentifier::VARCHAR;
     }
@@ -1051,8 +1054,8 @@ bool SystemManager::insertIntoTable(const char* table_name,
     utils::joinPaths(table_path, RECORD_FILE_NAME, &record_path);
 
     // get column types
-    std::vector<record::ColumnType> column_types;
-    rm->getColumnTypes(record_path, column_types);
+    record::TableSchemaPtr schema = rm->getSchema(record_path);
+    const std::vector<record::ColumnType>& column_types = schema->columns;
 
     // get primary keys
     std::set<int> primary_keys;
@@ -1139,10 +1142,10 @@ bool SystemManager::insertIntoTable(const char* table_name,
 
             // upd 检查是否重复
             std::vector<record::DataItem> result_datas;
-            std::vector<record::ColumnType> result_column_types;
+            record::TableSchemaPtr result_schema;
             std::vector<record::RecordLocation> record_locations;
             searchRowsInTable(table_id, primary_constraints, result_datas,
-                   result_column_types, record_locations, -1);
+                   result_schema, record_locations, -1);
             if (result_datas.size() > 0) {
                 std::cout << "!ERROR" << std::endl;
                 std::cout << "duplicate" << std::endl;
@@ -1183,10 +1186,10 @@ bool SystemManager::insertIntoTable(const char* table_name,
             }
 
             std::vector<record::DataItem> result_datas;
-            std::vector<record::ColumnType> result_column_types;
+            record::TableSchemaPtr result_schema;
             std::vector<record::RecordLocation> record_locations;
             searchRowsInTable(foreign_key_info.reference_table_id, constraints,
-                   result_datas, result_column_types, record_locations, -1);
+                   result_datas, result_schema, record_locations, -1);
             if (result_datas.size() == 0) {
                 std::cout << "!ERROR" << std::endl;
                 std::cout << "foreign key does not exist" << std::endl;
@@ -1204,8 +1207,6 @@ bool SystemManager::insertIntoTable(const char* table_name,
     std::vector<std::string> index_names;
     getAllIndex(currentDatabaseId, table_id, all_index, index_names);
 
-    rm->getColumnTypes(record_path, column_types);
-
     for (auto& data_item : data_items) {
         // check unique
         for (auto& column : column_types) {
@@ -1223,7 +1224,8 @@ bool SystemManager::insertIntoTable(const char* table_name,
                     break;
                 }
             }
-            searchRowsInTable(table_id, constraints, result_datas, column_types,
+            record::TableSchemaPtr result_schema;
+            searchRowsInTable(table_id, constraints, result_datas, result_schema,
                    record_locations, -1);
             if (result_datas.size() > 0) {
                 std::cout << "!ERROR" << std::endl;
@@ -1275,8 +1277,8 @@ void SystemManager::fillInDataTypeField(
     char* record_path = nullptr;
     utils::joinPaths(table_path, RECORD_FILE_NAME, &record_path);
 
-    std::vector<record::ColumnType> column_types;
-    rm->getColumnTypes(record_path, column_types);
+    record::TableSchemaPtr schema = rm->getSchema(record_path);
+    const std::vector<record::ColumnType>& column_types = schema->columns;
 
     for (auto& info : update_info) {
         std::string& table_name = std::get<0>(info);
@@ -1306,8 +1308,8 @@ void SystemManager::fillInDataTypeField(
     char* record_path = nullptr;
     utils::joinPaths(table_path, RECORD_FILE_NAME, &record_path);
 
-    std::vector<record::ColumnType> column_types;
-    rm->getColumnTypes(record_path, column_types);
+    record::TableSchemaPtr schema = rm->getSchema(record_path);
+    const std::vector<record::ColumnType>& column_types = schema->columns;
 
     for (auto& constraint : constraints) {
         if (constraint.dataType == record::DataTypeIdentifier::ANY) {
@@ -1334,8 +1336,8 @@ std::string SystemManager::findTableNameOfColumnName(
             return "";
         }
 
-        std::vector<record::ColumnType> column_types;
-        getTableColumnTypes(table_id, column_types);
+        record::TableSchemaPtr schema = getTableSchema(table_id);
+        const std::vector<record::ColumnType>& column_types = schema->columns;
         for (int i = 0; i < column_types.size(); i++) {
             if (column_types[i].columnName == column_name) {
                 if (selected_table_name != "") {
@@ -1360,8 +1362,8 @@ bool SystemManager::getColumnID(int table_id,
     utils::joinPaths(table_path, RECORD_FILE_NAME, &record_path);
 
     // get column types
-    std::vector<record::ColumnType> column_types;
-    rm->getColumnTypes(record_path, column_types);
+    record::TableSchemaPtr schema = rm->getSchema(record_path);
+    const std::vector<record::ColumnType>& column_types = schema->columns;
 
     // get column id
     for (auto& column_name : column_names) {
@@ -1391,12 +1393,13 @@ bool SystemManager::updateRows(int table_id,
                            const record::DataItem& update_data) {
     // searchRowsInTable those satisfy constraints
     std::vector<record::DataItem> result_datas;
-    std::vector<record::ColumnType> column_types;
+    record::TableSchemaPtr schema;
     std::vector<record::RecordLocation> record_location_results;
-    if (!searchRowsInTable(table_id, constraints, result_datas, column_types,
+    if (!searchRowsInTable(table_id, constraints, result_datas, schema,
                 record_location_results, -1)) {
         return false;
     }
+    const std::vector<record::ColumnType>& column_types = schema->columns;
 
     // get primary key id
     std::set<int> primary_keys;
@@ -1504,9 +1507,9 @@ bool SystemManager::updateRows(int table_id,
             }
             if (equal_old) continue;
             std::vector<record::DataItem> result_datas;
-            std::vector<record::ColumnType> result_column_types;
+            record::TableSchemaPtr result_schema;
             std::vector<record::RecordLocation> record_locations;
-            searchRowsInTable(table_id, constraints, result_datas, result_column_types,
+            searchRowsInTable(table_id, constraints, result_datas, result_schema,
                    record_locations, -1);
             if (result_datas.size() > 0) {
                 std::cout << "!ERROR" << std::endl;
@@ -1542,10 +1545,10 @@ bool SystemManager::updateRows(int table_id,
                 primary_constraints.push_back(constraint);
             }
             std::vector<record::DataItem> result_datas;
-            std::vector<record::ColumnType> result_column_types;
+            record::TableSchemaPtr result_schema;
             std::vector<record::RecordLocation> record_locations;
             searchRowsInTable(table_id, primary_constraints, result_datas,
-                   result_column_types, record_locations, -1);
+                   result_schema, record_locations, -1);
             if (result_datas.size() > 0 &&
                 !(result_datas.size() == 1 &&
                   result_datas[0].dataId == result_data.dataId)) {
@@ -1597,10 +1600,10 @@ bool SystemManager::updateRows(int table_id,
                             dominate_constraints.push_back(constraint);
                         }
                         std::vector<record::DataItem> result_datas;
-                        std::vector<record::ColumnType> result_column_types;
+                        record::TableSchemaPtr result_schema;
                         std::vector<record::RecordLocation> record_locations;
                         searchRowsInTable(dominate_table_id, dominate_constraints,
-                               result_datas, result_column_types,
+                               result_datas, result_schema,
                                record_locations, -1);
                         if (result_datas.size() > 0) {
                             std::cout << "!ERROR" << std::endl;
@@ -1665,11 +1668,11 @@ bool SystemManager::updateRows(int table_id,
                         foreign_key_constraints.push_back(constraint);
                 }
                 std::vector<record::DataItem> result_datas;
-                std::vector<record::ColumnType> result_column_types;
+                record::TableSchemaPtr result_schema;
                 std::vector<record::RecordLocation> record_locations;
                 searchRowsInTable(foreign_key_info.reference_table_id,
                        foreign_key_constraints, result_datas,
-                       result_column_types, record_locations, -1);
+                       result_schema, record_locations, -1);
                 if (result_datas.size() == 0) {
                     std::cout << "!ERROR" << std::endl;
                     std::cout << "foreign key does not exist" << std::endl;
@@ -1759,12 +1762,13 @@ bool SystemManager::deleteRowsFromTable(
     int table_id, std::vector<SearchConstraint>& constraints) {
     // searchRowsInTable those satisfy constraints
     std::vector<record::DataItem> result_datas;
-    std::vector<record::ColumnType> column_types;
+    record::TableSchemaPtr schema;
     std::vector<record::RecordLocation> record_location_results;
-    if (!searchRowsInTable(table_id, constraints, result_datas, column_types,
+    if (!searchRowsInTable(table_id, constraints, result_datas, schema,
                 record_location_results, -1)) {
         return false;
     }
+    const std::vector<record::ColumnType>& column_types = schema->columns;
 
     // get primary key id
     std::set<int> primary_keys;
@@ -1826,10 +1830,10 @@ bool SystemManager::deleteRowsFromTable(
                         dominate_constraints.push_back(constraint);
                     }
                     std::vector<record::DataItem> result_datas;
-                    std::vector<record::ColumnType> result_column_types;
+                    record::TableSchemaPtr result_schema;
                     std::vector<record::RecordLocation> record_locations;
                     searchRowsInTable(dominate_table_id, dominate_constraints,
-                           result_datas, result_column_types, record_locations,
+                           result_datas, result_schema, record_locations,
                            -1);
                     if (result_datas.size() > 0) {
                         std::cout << "!ERROR" << std::endl;
@@ -2147,8 +2151,8 @@ bool SystemManager::searchAndSave(int tableId,
         delete[] tablePath;
         delete[] recordPath;
 
-        rm->insertRecordsToEmptyRecord(savePath.c_str(), filePath.c_str(), ",", false);
-        return true;
+        return rm->insertRecordsToEmptyRecord(savePath.c_str(), filePath.c_str(), ",",
+                                              false) != -1;
     } else {
         index::IndexValue indexRangeLow, indexRangeHigh;
         for (int i = 0; i < overlapCount; i++) {
@@ -2222,16 +2226,17 @@ bool SystemManager::searchAndSave(int tableId,
         outputFile.close();
         totalNum = count;
 
-        rm->insertRecordsToEmptyRecord(savePath.c_str(), filePath.c_str(), ",", false);
-        return true;
+        return rm->insertRecordsToEmptyRecord(savePath.c_str(), filePath.c_str(), ",",
+                                              false) != -1;
     }
 }
 
 bool SystemManager::searchRowsInTable(
     int tableId, std::vector<SearchConstraint>& constraints,
     std::vector<record::DataItem>& resultDatas,
-    std::vector<record::ColumnType>& columnTypes,
-    std::vector<record::RecordLocation>& recordLocationResults, int sortBy) {
+    record::TableSchemaPtr& schema,
+    std::vector<record::RecordLocation>& recordLocationResults, int sortBy,
+    const record::ColumnMask& columnMask) {
     if (currentDatabaseId == -1) {
         std::cout << "!ERROR" << std::endl;
         std::cout << "No database selected" << std::endl;
@@ -2239,11 +2244,11 @@ bool SystemManager::searchRowsInTable(
     }
 
     resultDatas.clear();
-    columnTypes.clear();
     recordLocationResults.clear();
 
-    // Get column types for the table
-    getTableColumnTypes(tableId, columnTypes);
+    // Get the schema of the table
+    schema = getTableSchema(tableId);
+    const std::vector<record::ColumnType>& columnTypes = schema->columns;
 
     bool hasItems = mergeConstraints(constraints);
 
@@ -2316,7 +2321,8 @@ bool SystemManager::searchRowsInTable(
         char* recordPath = nullptr;
         utils::joinPaths(tablePath, RECORD_FILE_NAME, &recordPath);
 
-        rm->getAllRecordWithConstraint(recordPath, resultDatas, recordLocationResults, constraints);
+        rm->getAllRecordWithConstraint(recordPath, resultDatas, recordLocationResults, constraints,
+                                       columnMask);
 
         delete[] tablePath;
         delete[] recordPath;
@@ -2437,7 +2443,7 @@ bool SystemManager::dropTable(const char* table_name) {
 
     im->closeAllCurrentFile();
     rm->closeAllCurrentFile();
-    rm->cleanAllCurrentColumnTypes();
+    rm->invalidateAllSchemas();
 
     // delete table folder
     assert(fm->deleteFolder(table_path));
@@ -2465,14 +2471,19 @@ bool SystemManager::dropTable(const char* table_name) {
 
 bool SystemManager::getTableColumnTypes(
     int table_id, std::vector<record::ColumnType>& column_types) {
+    column_types = getTableSchema(table_id)->columns;
+    return true;
+}
+
+record::TableSchemaPtr SystemManager::getTableSchema(int table_id) {
     char* table_path = nullptr;
     getTableRecordPath(currentDatabaseId, table_id, &table_path);
     char* record_path = nullptr;
     utils::joinPaths(table_path, RECORD_FILE_NAME, &record_path);
-    rm->getColumnTypes(record_path, column_types);
+    record::TableSchemaPtr schema = rm->getSchema(record_path);
     delete[] table_path;
     delete[] record_path;
-    return true;
+    return schema;
 }
 
 bool SystemManager::getTablePrimaryKeys(int table_id,
@@ -2549,8 +2560,8 @@ bool SystemManager::getTableForeignKeys(
         foreignKeys.push_back(ForeignKeyInfo(
             foreignKeyColumnIds, dataItem.values[0].value.intValue,
             referenceColumnIds,
-            dataItem.values[FOREIGN_KEY_MAX_NUM * 2 + 1]
-                .value.charValue));
+            std::string(
+                dataItem.values[FOREIGN_KEY_MAX_NUM * 2 + 1].chars())));
     }
 
     // Clean up dynamically allocated memory
@@ -2718,8 +2729,7 @@ bool SystemManager::describeTable(
         std::string reference_table_name;
         for (auto& data_item : data_items) {
             if (data_item.dataId == foreign_key_info.reference_table_id) {
-                reference_table_name =
-                    data_item.values[0].value.charValue;
+                reference_table_name = data_item.values[0].chars();
                 break;
             }
         }
@@ -2816,106 +2826,65 @@ bool SystemManager::loadTableFromFile(const char* table_name,
     char* record_path = nullptr;
     utils::joinPaths(table_path, RECORD_FILE_NAME, &record_path);
 
-    int data_item_per_page =
-        rm->insertRecordsToEmptyRecord(record_path, file_path, delimeter, true);
-    if (data_item_per_page == -1) {
-        return false;
-    }
-    std::vector<record::ColumnType> column_types;
-    rm->getColumnTypes(record_path, column_types);
+    auto load_start = std::chrono::steady_clock::now();
 
     std::vector<std::pair<int, std::vector<int>>> all_index;
     std::vector<std::string> index_names;
     getAllIndex(currentDatabaseId, table_id, all_index, index_names);
 
-    std::ifstream csv_file(file_path);
-    if (!csv_file.is_open()) {
-        std::cerr << "Failed to open file " << file_path << std::endl;
-        return false;
+    // The loader hands back the key columns of every index, so the file is
+    // only read once
+    std::vector<int> key_columns;
+    std::vector<char*> index_file_paths;
+    for (auto& index : all_index) {
+        key_columns.insert(key_columns.end(), index.second.begin(),
+                           index.second.end());
+        char* index_file_path = nullptr;
+        getIndexRecordPath(currentDatabaseId, table_id, index.first,
+                           &index_file_path);
+        index_file_paths.push_back(index_file_path);
     }
 
-    std::string line;
-    int pageId = 1, slotId = 0;
-    while (getline(csv_file, line)) {
-        if (slotId == data_item_per_page) {
-            pageId++;
-            slotId = 0;
-        }
-        std::vector<std::string> csv_row;
-        std::string item;
-        for (int i = 0; i < line.length(); i++) {
-            if (line[i] == delimeter[0]) {
-                csv_row.push_back(item);
-                item = "";
-            } else {
-                item += line[i];
-            }
-        }
-        csv_row.push_back(item);
-
-        record::DataItem data_item;
-        int csv_row_idx = 0;
-        for (auto& column : column_types) {
-            data_item.columnIds.push_back(column.columnId);
-            record::DateValue date_value;
-            std::istringstream iss;
-            double floatValue;
-            if (column.dataType == record::DataTypeIdentifier::FLOAT) {
-                std::istringstream iss(csv_row[csv_row_idx++]);
-                iss >> floatValue;
-            }
-            switch (column.dataType) {
-                case record::DataTypeIdentifier::INT:
-                    data_item.values.push_back(
-                        record::DataValue(record::DataTypeIdentifier::INT, false,
-                                          std::stoi(csv_row[csv_row_idx++])));
-                    break;
-                case record::DataTypeIdentifier::FLOAT:
-                    data_item.values.push_back(record::DataValue(
-                        record::DataTypeIdentifier::FLOAT, false, floatValue));
-                    break;
-                case record::DataTypeIdentifier::VARCHAR:
-                    data_item.values.push_back(
-                        record::DataValue(record::DataTypeIdentifier::VARCHAR, false,
-                                          csv_row[csv_row_idx++]));
-                    break;
-                case record::DataTypeIdentifier::DATE:
-                    date_value.year = std::stoi(csv_row[csv_row_idx].substr(
-                        0, csv_row[csv_row_idx].find('-')));
-                    date_value.month = std::stoi(csv_row[csv_row_idx].substr(
-                        csv_row[csv_row_idx].find('-') + 1,
-                        csv_row[csv_row_idx].rfind('-') -
-                            csv_row[csv_row_idx].find('-') - 1));
-                    date_value.day = std::stoi(csv_row[csv_row_idx].substr(
-                        csv_row[csv_row_idx].rfind('-') + 1));
-                    csv_row_idx++;
-                    data_item.values.push_back(record::DataValue(
-                        record::DataTypeIdentifier::DATE, false, date_value));
-                    break;
-            }
+    std::vector<record::RecordLocation> record_locations;
+    std::vector<int> keys;
+    int data_item_per_page = rm->insertRecordsToEmptyRecord(
+        record_path, file_path, delimeter, true, &record_locations, key_columns,
+        &keys);
+    bool loaded = data_item_per_page != -1;
+
+    // build each index from its sorted keys instead of inserting row by row
+    int key_num = key_columns.size();
+    for (int i = 0, key_offset = 0; loaded && i < all_index.size(); i++) {
+        int index_key_num = all_index[i].second.size();
+        index::IndexSorter entries(index_file_paths[i]);
+        for (int row = 0; row < record_locations.size(); row++) {
+            auto& record_location = record_locations[row];
+            entries.add(record_location.pageId, record_location.slotId,
+                        keys.data() + row * key_num + key_offset,
+                        index_key_num);
+        }
+        if (!im->bulkBuildIndex(index_file_paths[i], index_key_num, entries)) {
+            std::cout << "!ERROR" << std::endl;
+            std::cout << "Failed to sort index entries" << std::endl;
+            loaded = false;
         }
+        key_offset += index_key_num;
+    }
 
-        for (auto& index : all_index) {
-            char* index_file_path = nullptr;
-            getIndexRecordPath(currentDatabaseId, table_id, index.first,
-                               &index_file_path);
-            index::IndexValue index_value(pageId, slotId, 0);
-            for (auto& index_id : index.second) {
-                if (data_item.values[index_id].isNull == false)
-                    index_value.key.push_back(
-                        data_item.values[index_id].value.intValue);
-                else
-                    index_value.key.push_back(INT_MIN);
-            }
-            assert(im->insertIndex(index_file_path, index_value));
-            delete[] index_file_path;
-        }
-        slotId++;
+    if (loaded) {
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - load_start;
+        double seconds = std::max(elapsed.count(), 1e-9);
+        std::cerr << "Loaded " << record_locations.size() << " rows in "
+                  << std::fixed << std::setprecision(3) << seconds << " s ("
+                  << std::setprecision(0) << record_locations.size() / seconds
+                  << " rows/s)" << std::defaultfloat << std::endl;
     }
 
+    for (auto index_file_path : index_file_paths) delete[] index_file_path;
     delete[] table_path;
     delete[] record_path;
-    return true;
+    return loaded;
 }
 
 void SystemManager::getAllIndex(
@@ -2944,7 +2913,7 @@ void SystemManager::getAllIndex(
         index_ids.push_back(std::make_pair(data_item.dataId, index_id));
         if (data_item.values[INDEX_KEY_MAX_NUM].isNull == false)
             index_names.push_back(
-                data_item.values[INDEX_KEY_MAX_NUM].value.charValue);
+                std::string(data_item.values[INDEX_KEY_MAX_NUM].chars()));
         else
             index_names.push_back("");
     }
@@ -2987,55 +2956,54 @@ int SystemManager::getTableId(const char* table_name) {
 
     // searchRowsInTable for the table name
     for (int i = 0; i < data_items.size(); i++) {
-        if (strcmp(data_items[i].values[0].value.charValue.c_str(),
-                   table_name) == 0) {
+        if (data_items[i].values[0].chars() == table_name) {
             return data_items[i].dataId;
         }
     }
     return -1;
 }
 
+const std::string& SystemManager::cachedPath(int database_id, int table_id,
+                                             int index_id) const {
+    // ids are non-negative and far below 2^20; -1 packs to 0
+    uint64_t key = (static_cast<uint64_t>(database_id + 1) << 42) |
+                   (static_cast<uint64_t>(table_id + 1) << 21) |
+                   static_cast<uint64_t>(index_id + 1);
+    auto it = path_cache.find(key);
+    if (it != path_cache.end()) return it->second;
+
+    std::string path;
+    if (table_id == -1) {
+        path = std::string(DATABASE_BASE_PATH) + "/" + DATABSE_FOLDER_PREFIX +
+               std::to_string(database_id);
+    } else if (index_id == -1) {
+        path = cachedPath(database_id, -1, -1) + "/" + TABLE_FOLDER_PREFIX +
+               std::to_string(table_id);
+    } else {
+        path = cachedPath(database_id, table_id, -1) + "/" + INDEX_FOLDER_NAME +
+               "/" + INDEX_FILE_PREFIX + std::to_string(index_id);
+    }
+    return path_cache.emplace(key, std::move(path)).first->second;
+}
+
 void SystemManager::getDatabasePath(int database_id, char** result) const {
-    char* folder_name = nullptr;
-    char* database_id_str = nullptr;
-    
-    utils::integerToString(database_id, & database_id_str);
-    utils::joinStrings(DATABSE_FOLDER_PREFIX, database_id_str, &folder_name);
-    utils::joinPaths(DATABASE_BASE_PATH, folder_name, result);
-
-    delete[] folder_name;
-    delete[] database_id_str;
+    const std::string& path = cachedPath(database_id, -1, -1);
+    *result = new char[path.size() + 1];
+    memcpy(*result, path.c_str(), path.size() + 1);
 }
 
 void SystemManager::getTableRecordPath(int database_id, int table_id,
                                        char** result) {
-    char* database_path = nullptr;
-    getDatabasePath(database_id, &database_path);
-    char* table_id_str = nullptr;
-    utils::integerToString(table_id, &table_id_str);
-    char* folder_name = nullptr;
-    utils::joinStrings(TABLE_FOLDER_PREFIX, table_id_str, &folder_name);
-    utils::joinPaths(database_path, folder_name, result);
-    delete[] database_path;
-    delete[] table_id_str;
-    delete[] folder_name;
+    const std::string& path = cachedPath(database_id, table_id, -1);
+    *result = new char[path.size() + 1];
+    memcpy(*result, path.c_str(), path.size() + 1);
 }
 
 void SystemManager::getIndexRecordPath(int database_id, int table_id,
                                        int index_id, char** result) {
-    char* table_path = nullptr;
-    getTableRecordPath(database_id, table_id, &table_path);
-    char* index_id_str = nullptr;
-    utils::integerToString(index_id, &index_id_str);
-    char* file_name = nullptr;
-    utils::joinStrings(INDEX_FILE_PREFIX, index_id_str, &file_name);
-    char* folder_path = nullptr;
-    utils::joinPaths(table_path, INDEX_FOLDER_NAME, &folder_path);
-    utils::joinPaths(folder_path, file_name, result);
-    delete[] table_path;
-    delete[] index_id_str;
-    delete[] file_name;
-    delete[] folder_path;
+    const std::string& path = cachedPath(database_id, table_id, index_id);
+    *result = new char[path.size() + 1];
+    memcpy(*result, path.c_str(), path.size() + 1);
 }
 
 int SystemManager::getActiveDatabaseId() const { 
@@ -3051,7 +3019,7 @@ std::string SystemManager::getDatabaseName(int databaseId){
     getAllDatabase(databaseNames, columnTypes);
     for (auto& database : databaseNames) {
         if (database.dataId == databaseId) {
-            databaseName = database.values[0].value.charValue;
+            databaseName = database.values[0].chars();
             break;
         }
     }
@@ -5,7 +5,7 @@ namespace utils {
 
 BitMap::BitMap(int mapCapacity, bool initialValue) {
     bitCapacity = mapCapacity;  // in bit
-    mapSize = (mapCapacity >> BIT_MAP_BIAS);  // Calculate how many words are needed.
+    mapSize = ((mapCapacity + BIT_PER_BUF_MASK) >> BIT_MAP_BIAS);  // Calculate how many words are needed (rounded up).
     bitData = new uint[mapSize];              // Allocate memory for the bit map.
 
     // Initialize the bit map based on the initial value.
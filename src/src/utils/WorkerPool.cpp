@@ -0,0 +1,74 @@
+#include "utils/WorkerPool.hpp"
+
+namespace dbs {
+namespace utils {
+
+WorkerPool::WorkerPool(int threads) {
+    if (threads <= 0) {
+        threads = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    batch = nullptr;
+    batchSize = 0;
+    nextTask = 0;
+    generation = 0;
+    busyWorkers = 0;
+    stopping = false;
+    for (int i = 1; i < threads; i++) {
+        workers.emplace_back(&WorkerPool::workerLoop, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        stopping = true;
+    }
+    started.notify_all();
+    for (auto& worker : workers) worker.join();
+}
+
+void WorkerPool::run(int taskCount, const std::function<void(int)>& task) {
+    if (taskCount <= 0) return;
+    if (workers.empty() || taskCount == 1) {
+        for (int i = 0; i < taskCount; i++) task(i);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+        batch = &task;
+        batchSize = taskCount;
+        nextTask = 0;
+        generation++;
+        busyWorkers = static_cast<int>(workers.size());
+    }
+    started.notify_all();
+    work();
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this] { return busyWorkers == 0; });
+    batch = nullptr;
+}
+
+void WorkerPool::workerLoop() {
+    unsigned long long seen = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        started.wait(lock, [&] { return stopping || generation != seen; });
+        if (stopping) return;
+        seen = generation;
+        lock.unlock();
+        work();
+        lock.lock();
+        if (--busyWorkers == 0) finished.notify_one();
+    }
+}
+
+void WorkerPool::work() {
+    while (true) {
+        int task = nextTask.fetch_add(1);
+        if (task >= batchSize) return;
+        (*batch)(task);
+    }
+}
+
+}  // namespace utils
+}  // namespace dbs